@@ -27,6 +27,7 @@
 
 #include <cstddef>
 #include <pthread.h>
+#include "../misc/pool.h"
 
 template <class NodeType>
 class InsertionTree {
@@ -54,6 +55,10 @@ public:
           || (numOfLeaves & (numOfLeaves - 1)) == 0; // is power of 2
   }
   
+  /**
+   * Destroys the inner nodes and empties the tree,
+   * the leaves are owned by whoever added them.
+   */
   void free();
 
 private:
@@ -66,8 +71,10 @@ private:
   size_t numOfLeaves;
   
   pthread_mutex_t lock;
+  NodePool<NodeType> innerNodes;  // protected by the lock
   
   NodeType* insertionNode();
+  void freeInnerNodes(NodeType* const node);
 };
 
 #include "InsertionTree.impl.h"
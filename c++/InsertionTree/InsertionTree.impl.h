@@ -50,7 +50,7 @@ void InsertionTree<ConcreteNodeType>::addNode(ConcreteNodeType* const node) {
   }
  
   // The general case
-  ConcreteNodeType* const tmpNode = new ConcreteNodeType();
+  ConcreteNodeType* const tmpNode = ::new (innerNodes.allocate()) ConcreteNodeType();
   tmpNode->setLeftChild(insertNode);
   tmpNode->setRightChild(node);
 
@@ -97,7 +97,34 @@ ConcreteNodeType* InsertionTree<ConcreteNodeType>::insertionNode() {
 
 template <class ConcreteNodeType>
 void InsertionTree<ConcreteNodeType>::free() {
-  // TODO NOTYETIMPLEMENTED
+  pthread_mutex_lock(&lock);
+  
+  if (rootNode != NULL) {
+    freeInnerNodes(rootNode);
+  }
+  
+  rootNode  = NULL;
+  firstNode = NULL;
+  lastNode  = NULL;
+  
+  _height     = 0;
+  numOfNodes  = 0;
+  numOfLeaves = 0;
+  
+  pthread_mutex_unlock(&lock);
+}
+
+template <class ConcreteNodeType>
+void InsertionTree<ConcreteNodeType>::freeInnerNodes(ConcreteNodeType* const node) {
+  // all inner nodes were created by addNode(), and have two children
+  if (node->isLeaf()) {
+    return;
+  }
+  
+  freeInnerNodes(node->getLeftChild());
+  freeInnerNodes(node->getRightChild());
+  
+  innerNodes.release(node);
 }
 
 
@@ -61,10 +61,14 @@ public:
    **/
   vector<ValueType*> as_vector() const;
   
+  /**
+   * Deletes the leaves created by add(), the values are not deleted.
+   */
   void free();
 
 private:
   size_t collectLeaves(NodeType* const node, vector<ValueType*>* result, size_t i) const;
+  void collectLeafNodes(NodeType* const node, vector<NodeType*>* result) const;
 };
 
 #include "InsertionTreeWithValue.impl.h"
@@ -63,9 +63,32 @@ NodeType* InsertionTreeWithValue<NodeType, ValueType>::add(ValueType& value) {
   return node;
 }
 
+template <class NodeType, typename ValueType>
+void InsertionTreeWithValue<NodeType, ValueType>::collectLeafNodes(NodeType* const node, vector<NodeType*>* const result) const {
+  if (node->isLeaf()) {
+    result->push_back(node);
+    return;
+  }
+  
+  collectLeafNodes(node->getLeftChild(), result);
+  if (node->getRightChild() != NULL) {
+    collectLeafNodes(node->getRightChild(), result);
+  }
+}
+
 template <class NodeType, typename ValueType>
 void InsertionTreeWithValue<NodeType, ValueType>::free() {
-  // TODO NOTYETIMPLEMENTED
+  vector<NodeType*> leaves;
+  if (this->root() != NULL) {
+    collectLeafNodes(this->root(), &leaves);
+  }
+  
+  // the inner nodes are released by the tree, it only looks at the leaves
+  InsertionTree<NodeType>::free();
+  
+  for (size_t i = 0; i < leaves.size(); i++) {
+    delete leaves[i];
+  }
 }
 
 
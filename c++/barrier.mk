@@ -37,14 +37,46 @@ OPT     ?= -O3 -no_exceptions
 NUM_PARTICIPANTS     ?= 2
 SKIP_REFERENCE_TIME  ?= 0
 DO_YIELD             ?= 0
+USE_PADDING          ?= 1
 OS ?= $(shell uname)
 
 # required settings
 LOG2_NUM_PARTICIPANTS := $(shell php -r 'echo ceil(log($(NUM_PARTICIPANTS), 2));')
 
-DEFINES   = -DNUM_PARTICIPANTS=$(NUM_PARTICIPANTS) -DLOG2_NUM_PARTICIPANTS=$(LOG2_NUM_PARTICIPANTS) -DSKIP_REFERENCE_TIME=$(SKIP_REFERENCE_TIME) -DDO_YIELD=$(DO_YIELD)
+DEFINES   = -DNUM_PARTICIPANTS=$(NUM_PARTICIPANTS) -DLOG2_NUM_PARTICIPANTS=$(LOG2_NUM_PARTICIPANTS) -DSKIP_REFERENCE_TIME=$(SKIP_REFERENCE_TIME) -DDO_YIELD=$(DO_YIELD) -DUSE_PADDING=$(USE_PADDING)
 LIBS     += -lpthread
 
+# SpinWait, PauseWait, ExponentialBackoffWait, YieldWait, or ParkWait
+ifdef WAIT_POLICY
+  DEFINES += -DWAIT_POLICY=$(WAIT_POLICY)
+endif
+
+# release SyncTree participants through the helper nodes (1) or the global phase (0)
+ifdef SYNC_TREE_RELEASE
+  DEFINES += -DSYNC_TREE_RELEASE=$(SYNC_TREE_RELEASE)
+endif
+
+# place SyncTree participants by the cache domains of their CPU (1) or in registration order (0)
+ifdef SYNC_TREE_TOPOLOGY
+  DEFINES += -DSYNC_TREE_TOPOLOGY=$(SYNC_TREE_TOPOLOGY)
+endif
+
+ifdef CALIBRATED_DELAY
+  DEFINES += -DCALIBRATED_DELAY=$(CALIBRATED_DELAY)
+endif
+
+ifdef EPISODE_STATS
+  DEFINES += -DEPISODE_STATS=$(EPISODE_STATS)
+endif
+
+ifdef BARRIER_STATS
+  DEFINES += -DBARRIER_STATS=$(BARRIER_STATS)
+endif
+
+ifdef BARRIER_TRACE
+  DEFINES += -DBARRIER_TRACE=$(BARRIER_TRACE)
+endif
+
 CXXFLAGS += $(INCLUDES) $(DEFINES) -Wall $(OPT)
 CFLAGS   += $(INCLUDES) $(DEFINES) -Wall $(OPT)
 LFLAGS   += $(OPT)
@@ -53,22 +85,38 @@ LFLAGS   += $(OPT)
 # all portable barrier implementations, platfrom dependent ones are added later
 BARRIERS = \
   DummyBarrier \
+  AdaptiveBarrier \
   SyncTreePhaser.full \
   ConstSpinningDisseminationBarrier \
+  ConstMCSTreeBarrier \
+  ConstTournamentBarrier \
   SpinningCentralBarrier \
   SpinningCentralCASBarrier \
   SpinningCentralDBarrier \
+  SpinningCentralShardedBarrier \
   SpinningDisseminationBarrier \
+  SpinningDisseminationDBarrier \
   SyncTreePhaser \
   ConstSyncTreeBarrier \
+  HierarchicalBarrier \
   HabaneroPhaser
 
 DYNAMIC_BARRIERS = \
 	SpinningCentralDBarrier \
+	SpinningCentralShardedBarrier \
+	SpinningDisseminationDBarrier \
 	SyncTreePhaser \
 	HabaneroPhaser \
 	DummyBarrier
 
+# barriers with SyncTree accumulators, verified by the reduce benchmark
+ACCUMULATOR_BARRIERS = \
+	SyncTreePhaser
+
+# barriers with bounded SyncTree phasers, verified by the bounded benchmark
+BOUNDED_BARRIERS = \
+	SyncTreePhaser
+
 
 	#   SpinningTreeBarrier.b  is completely broken and superseeded by SyncTree*
 
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ * A meta-barrier which switches between two barrier algorithms based on the
+ * observed arrival skew. Every ADAPTIVE_SAMPLE_INTERVAL episodes, all
+ * participants record their arrival time. After that episode, the first
+ * participant computes the spread between the first and the last arrival
+ * and selects the algorithm for the following episodes.
+ *
+ * When all participants arrive at about the same time, the arrival is
+ * contended and a tree distributes that contention best. When arrivals are
+ * spread out, only the latency after the last arrival matters, and the
+ * central barrier has the shortest path from the last arrival to the release.
+ *
+ * The decision taken after episode e is only read at the start of
+ * episode e + 2. Since the first participant publishes it before arriving at
+ * episode e + 1, all participants are guaranteed to see the same decision,
+ * and switch at the same phase boundary without additional synchronization.
+ */
+
+#ifndef BARRIER
+  #define BARRIER     AdaptiveBarrier<ConstTree::Barrier, ConstTree::Participant, SpinningCentralBarrier, Participant>
+#endif
+
+#ifndef PARTICIPANT
+  #define PARTICIPANT AdaptiveBarrier<ConstTree::Barrier, ConstTree::Participant, SpinningCentralBarrier, Participant>::Participant
+#endif
+
+// the default composition
+#include "ConstSyncTreeBarrier.h"
+#include "SpinningCentralBarrier.h"
+
+#include <cstddef>
+#include <stdint.h>
+#include "../misc/atomic.h"
+#include "../misc/misc.h"
+#include "../misc/align.h"
+#include "../misc/get_clock.h"
+
+#ifndef ADAPTIVE_SAMPLE_INTERVAL
+  #define ADAPTIVE_SAMPLE_INTERVAL 16   // has to be at least 3, see above
+#endif
+
+/**
+ * Arrival spread in nanoseconds above which the high-skew algorithm is used,
+ * switching back happens only below half of it to avoid oscillation.
+ */
+#ifndef ADAPTIVE_SKEW_THRESHOLD
+  #define ADAPTIVE_SKEW_THRESHOLD 10000
+#endif
+
+template<class LowSkewBarrier, class LowSkewParticipant, class HighSkewBarrier, class HighSkewParticipant>
+class AdaptiveBarrier {
+public:
+  
+  enum Algorithm {
+    LOW_SKEW,
+    HIGH_SKEW
+  };
+  
+  class Participant : public CacheLineAligned {
+  public:
+    Participant(AdaptiveBarrier* const barrier)
+    : _barrier(barrier),
+      lowSkew(new LowSkewParticipant(barrier->lowSkewBarrier)),
+      highSkew(new HighSkewParticipant(barrier->highSkewBarrier)),
+      id(barrier->add()),
+      episode(0),
+      algorithm(LOW_SKEW) {}
+    
+    inline bool resume() const {return false;}
+    inline bool next() {
+      return barrier();
+    }
+    
+    inline bool barrier() {
+      const size_t episodeInInterval = episode % ADAPTIVE_SAMPLE_INTERVAL;
+      
+      if (episodeInInterval == 0) {
+        _barrier->arrivals[id].value = get_clock_ns();
+      }
+      else if (episodeInInterval == 2) {
+        algorithm = _barrier->algorithm;
+      }
+      
+      bool result;
+      if (algorithm == LOW_SKEW) {
+        result = lowSkew->barrier();
+      }
+      else {
+        result = highSkew->barrier();
+      }
+      
+      if (episodeInInterval == 0 && id == 0) {
+        _barrier->adapt();
+      }
+      
+      episode++;
+      return result;
+    }
+    
+    void free() {}
+    
+  private:
+    AdaptiveBarrier* const _barrier;
+    
+    LowSkewParticipant*  const lowSkew;
+    HighSkewParticipant* const highSkew;
+    
+    const int id;
+    
+    size_t    episode;
+    Algorithm algorithm;   // local copy of the algorithm used in this interval
+  };
+  
+  AdaptiveBarrier(const size_t number_of_participants)
+  : number_of_participants(number_of_participants),
+    next_id(-1),
+    algorithm(LOW_SKEW),
+    lowSkewBarrier(new LowSkewBarrier(number_of_participants)),
+    highSkewBarrier(new HighSkewBarrier(number_of_participants)),
+    arrivals(new CacheLinePadded<volatile uint64_t>[number_of_participants]) {}
+  
+  void finalize_initialization() {
+    lowSkewBarrier->finalize_initialization();
+    highSkewBarrier->finalize_initialization();
+  }
+  
+  void free() {
+    delete[] arrivals;
+  }
+  
+  inline Algorithm currentAlgorithm() const { return algorithm; }
+  
+private:
+  int add() {
+    return atomic_add_and_fetch(&next_id, 1);
+  }
+  
+  /**
+   * Determine the arrival spread of the sampled episode, and select the
+   * algorithm for the next interval.
+   */
+  void adapt() {
+    uint64_t first = arrivals[0].value;
+    uint64_t last  = arrivals[0].value;
+    
+    for (size_t i = 1; i < number_of_participants; i++) {
+      const uint64_t time = arrivals[i].value;
+      if (time < first) first = time;
+      if (time > last)  last  = time;
+    }
+    
+    const uint64_t spread = last - first;
+    
+    if (spread > ADAPTIVE_SKEW_THRESHOLD) {
+      algorithm = HIGH_SKEW;
+    }
+    else if (spread < ADAPTIVE_SKEW_THRESHOLD / 2) {
+      algorithm = LOW_SKEW;
+    }
+  }
+  
+  const size_t number_of_participants;
+  int next_id;
+  
+  volatile Algorithm algorithm;
+  
+  LowSkewBarrier*  const lowSkewBarrier;
+  HighSkewBarrier* const highSkewBarrier;
+  
+  CacheLinePadded<volatile uint64_t>* const arrivals;
+};
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ * Implements the tree-based barrier algorithm presented in \cite{103729}
+ * Mellor-Crummey, John M. & Scott, Michael L.: 
+ *  Algorithms for Scalable Synchronization on Shared-Memory Multiprocessors
+ *  In: ACM Trans. Comput. Syst. , Vol. 9 , Nr. 1 New York, NY, USA: ACM (1991).
+ *
+ * Arrival is signaled up a FanIn-ary tree, every child owns one byte of its
+ * parent's packed childNotReady word. The release is propagated down a
+ * separate FanOut-ary wakeup tree. Every participant only spins on flags
+ * inside of its own Participant object.
+ */
+
+#include <cstddef>
+#include <stdint.h>
+#include "../misc/atomic.h"
+#include "../misc/misc.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
+
+#ifndef BARRIER
+  #define BARRIER ConstMCSTreeBarrier<NUM_PARTICIPANTS, 4, 2>
+#endif
+
+#ifndef PARTICIPANT
+  #define PARTICIPANT ConstMCSTreeBarrier<NUM_PARTICIPANTS, 4, 2>::Participant
+#endif
+
+template<int NumParticipants, int FanIn, int FanOut>
+class ConstMCSTreeBarrier {
+public:
+  
+  /**
+   * The childNotReady bytes are packed into a single word, thus, the arrival
+   * fan-in is limited by the size of that word.
+   */
+  union ChildFlags {
+    volatile uint64_t word;
+    volatile bool     bytes[sizeof(uint64_t)];
+  };
+  
+  class Participant : public CacheLineAligned {
+  public:
+    Participant(ConstMCSTreeBarrier* barrier) : parentSense(false), sense(true), isMaster(false) {
+      // a fan-in larger than the packed word would need a second word to spin on
+      typedef char fanInFitsIntoChildFlags[(FanIn <= (int)sizeof(uint64_t)) ? 1 : -1];
+      (void)sizeof(fanInFitsIntoChildFlags);
+      
+      barrier->add(this);
+      initialize();
+    }
+    
+    inline bool resume() const {return false;}
+    inline bool next() {
+      return barrier();
+    }
+    
+    inline bool barrier() {
+      // wait until all children in the arrival tree have arrived
+      WAIT_POLICY arrivalWaiter(&childNotReady.word);
+      while (atomic_load<ORDER_ACQUIRE>(&childNotReady.word) != 0) {
+        arrivalWaiter.wait();
+      }
+      
+      // prepare for the next episode, before anybody can be released
+      childNotReady.word = haveChild.word;
+      
+      // signal our own arrival to the parent
+      atomic_store<ORDER_RELEASE>(parentPointer, false);
+      WAIT_POLICY::wake(parentPointer);
+      
+      // the root does not have to wait, it is the one releasing all others
+      if (!isMaster) {
+        WAIT_POLICY wakeupWaiter(&parentSense);
+        while (atomic_load<ORDER_ACQUIRE>(&parentSense) != sense) {
+          wakeupWaiter.wait();
+        }
+      }
+      
+      // release the children in the wakeup tree
+      for (int i = 0; i < FanOut; i++) {
+        atomic_store<ORDER_RELEASE>(childPointers[i], sense);
+        WAIT_POLICY::wake(childPointers[i]);
+      }
+      
+      sense = !sense;
+      
+      // chose the master task statically
+      return isMaster;
+    }
+    
+    void free() {}
+    
+    void becomeMaster() {
+      isMaster = true;
+    }
+    
+  private:
+    void initialize() {
+      childNotReady.word = 0;
+      haveChild.word     = 0;
+      parentPointer      = &dummy;
+      
+      for (int i = 0; i < FanOut; i++) {
+        childPointers[i] = &dummy;
+      }
+    }
+    
+    // the flags spun on by this participant are kept on a separate cache
+    // line from the data the other participants write
+    CACHE_LINE_PAD(padding0);
+    
+    ChildFlags     childNotReady;
+    volatile bool  parentSense;
+    
+    CACHE_LINE_PAD(padding1);
+    
+    ChildFlags     haveChild;
+    volatile bool* parentPointer;
+    volatile bool* childPointers[FanOut];
+    
+    bool sense;
+    volatile bool dummy;   // target for non-existing parent and children
+    bool isMaster;
+    
+    CACHE_LINE_PAD(padding2);
+    
+    friend class ConstMCSTreeBarrier;
+  };
+  
+  
+  ConstMCSTreeBarrier(const size_t) : next_id(-1) {}
+  
+  /**
+   * Ensure that all invariants are fulfilled.
+   */
+  void finalize_initialization() {
+    for (int i = 0; i < NumParticipants; i++) {
+      Participant* const p = participants[i];
+      
+      // arrival tree: participant i is the child (i - 1) mod FanIn of (i - 1) / FanIn
+      for (int j = 0; j < FanIn; j++) {
+        p->haveChild.bytes[j] = (FanIn * i + j + 1) < NumParticipants;
+      }
+      p->childNotReady.word = p->haveChild.word;
+      
+      if (i != 0) {
+        p->parentPointer = &participants[(i - 1) / FanIn]->childNotReady.bytes[(i - 1) % FanIn];
+      }
+      
+      // wakeup tree: the children of i are FanOut * i + 1 ... FanOut * i + FanOut
+      for (int j = 0; j < FanOut; j++) {
+        const int childId = FanOut * i + j + 1;
+        if (childId < NumParticipants) {
+          p->childPointers[j] = &participants[childId]->parentSense;
+        }
+      }
+    }
+  }
+  
+  void free() {}
+  
+private:
+  void add(Participant* const participant) {
+    const int id = atomic_add_and_fetch(&next_id, 1);
+    
+    if (id == 0) {
+      participant->becomeMaster();
+    }
+    
+    participants[id] = participant;
+  }
+  
+  int next_id;
+
+  Participant* participants[NumParticipants];
+    
+};
@@ -25,25 +25,53 @@
  * Mellor-Crummey, John M. & Scott, Michael L.: 
  *  Algorithms for Scalable Synchronization on Shared-Memory Multiprocessors
  *  In: ACM Trans. Comput. Syst. , Vol. 9 , Nr. 1 New York, NY, USA: ACM (1991).
+ *
+ * Generalized to a radix k: in round r a participant i signals the k-1
+ * partners (i + j*k^r) mod P, with 0 < j < k, and waits for the k-1 signals
+ * it receives, which needs ceil(log_k P) rounds. Radix 2 is the original
+ * algorithm, larger radixes trade more stores per round for fewer rounds on
+ * the critical path.
  */
 
 #include <cstddef>
 #include <cmath>
 #include "../misc/atomic.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
+
+#ifndef DISSEMINATION_RADIX
+  #define DISSEMINATION_RADIX 2
+#endif
 
 #ifndef BARRIER
-  #define BARRIER ConstSpinningDisseminationBarrier<NUM_PARTICIPANTS, LOG2_NUM_PARTICIPANTS>
+  #define BARRIER ConstSpinningDisseminationBarrier<NUM_PARTICIPANTS, DISSEMINATION_RADIX>
 #endif
 
 #ifndef PARTICIPANT
-  #define PARTICIPANT ConstSpinningDisseminationBarrier<NUM_PARTICIPANTS, LOG2_NUM_PARTICIPANTS>::Participant
+  #define PARTICIPANT ConstSpinningDisseminationBarrier<NUM_PARTICIPANTS, DISSEMINATION_RADIX>::Participant
 #endif
 
-template<int NumParticipants, int Rounds>
+/**
+ * ceil(log_Radix(Value)), evaluated at compile time
+ */
+template<int Value, int Radix, int Power = 1, bool Reached = (Power >= Value)>
+struct DisseminationRounds {
+  enum { value = 1 + DisseminationRounds<Value, Radix, Power * Radix>::value };
+};
+
+template<int Value, int Radix, int Power>
+struct DisseminationRounds<Value, Radix, Power, true> {
+  enum { value = 0 };
+};
+
+template<int NumParticipants, int Radix>
 class ConstSpinningDisseminationBarrier {
 public:
   
-  class Participant {
+  enum { Rounds  = DisseminationRounds<NumParticipants, Radix>::value,
+         Fanout  = Radix - 1 };
+  
+  class Participant : public CacheLineAligned {
   public:
     Participant(ConstSpinningDisseminationBarrier* barrier): parity(0), sense(true), isMaster(false) {
       barrier->add(this);
@@ -56,12 +84,21 @@ public:
     }
     
     inline bool barrier() {
-      for (size_t dissemRound = 0; dissemRound < Rounds; dissemRound++) {			
-        *partner[parity][dissemRound] = sense;
+      for (size_t dissemRound = 0; dissemRound < Rounds; dissemRound++) {
+        const int partners = numPartners[dissemRound];
         
+        for (int j = 0; j < partners; j++) {
+          atomic_store<ORDER_RELEASE>(partner[parity][dissemRound][j], sense);
+          WAIT_POLICY::wake(partner[parity][dissemRound][j]);
+        }
         
-        volatile bool* const flag = &flags[parity][dissemRound];
-        while (*flag != sense);
+        for (int j = 0; j < partners; j++) {
+          volatile bool* const flag = &flags[parity][dissemRound][j].value;
+          WAIT_POLICY waiter(flag);
+          while (atomic_load<ORDER_ACQUIRE>(flag) != sense) {
+            waiter.wait();
+          }
+        }
       }
       
       if (parity == 1) {
@@ -76,8 +113,12 @@ public:
     
     void free() {}
   
-    volatile bool flags[2][Rounds];
-    volatile bool* partner[2][Rounds];
+    // every flag is written by a different partner
+    CacheLinePadded<volatile bool> flags[2][Rounds][Fanout];
+    volatile bool* partner[2][Rounds][Fanout];
+    
+    // in the last round, partners at a distance of P or more are skipped
+    int numPartners[Rounds];
     
     int  parity;
     bool sense;
@@ -90,7 +131,9 @@ public:
     void initialize() {      
       for (size_t parity = 0; parity < 2; parity++) {
         for (size_t round = 0; round < Rounds; round++) {
-          flags[parity][round] = false;
+          for (size_t j = 0; j < Fanout; j++) {
+            flags[parity][round][j].value = false;
+          }
         }
       }
     }
@@ -106,11 +149,21 @@ public:
    */
   void finalize_initialization() {
     // assign partners
-    for (size_t i = 0; i < NumParticipants; i++) {     
+    for (size_t i = 0; i < NumParticipants; i++) {
+      int distance = 1;  // k^r
+      
       for (int dissemRounds = 0; dissemRounds < Rounds; dissemRounds++) {
-        int partnerId = (i + (1 << dissemRounds)) % NumParticipants; //(i + 2^k) mod P
-        participants[i]->partner[0][dissemRounds] = &participants[partnerId]->flags[0][dissemRounds]; 
-        participants[i]->partner[1][dissemRounds] = &participants[partnerId]->flags[1][dissemRounds];
+        int partners = 0;
+        
+        for (int j = 1; j <= Fanout && j * distance < NumParticipants; j++) {
+          int partnerId = (i + j * distance) % NumParticipants; //(i + j*k^r) mod P
+          participants[i]->partner[0][dissemRounds][j - 1] = &participants[partnerId]->flags[0][dissemRounds][j - 1].value;
+          participants[i]->partner[1][dissemRounds][j - 1] = &participants[partnerId]->flags[1][dissemRounds][j - 1].value;
+          partners++;
+        }
+        
+        participants[i]->numPartners[dissemRounds] = partners;
+        distance *= Radix;
       }
     }
   }
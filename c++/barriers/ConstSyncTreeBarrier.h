@@ -19,6 +19,14 @@
  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
+ *
+ *
+ * The number of participants is fixed when the barrier is created, thus, the
+ * tree is laid out implicitly, like a binary heap, in a single array of
+ * cache line padded helper nodes. The node at index k has its parent at
+ * (k - 1) / 2, and for n participants, the leaves are the indexes n - 1 to
+ * 2n - 2. A resume climbs the tree by index arithmetic only, instead of
+ * chasing a parent pointer per level.
  */
 
 #include <cstdio>
@@ -36,7 +44,8 @@
 #include "../misc/misc.h"
 #include "../misc/atomic.h"
 #include "../misc/assert.h"
-#include "../misc/lock.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
 
 namespace ConstTree {
   
@@ -50,22 +59,8 @@ namespace ConstTree {
     } bits;
   };
   
-  class HelperNode;
-  class Participant;
-  
-  class TreeNode {
+  class HelperNode {
   public:
-    inline TreeNode() : parent(NULL) {}
-    
-    inline HelperNode* getParent() const { return parent; }
-    inline void setParent(HelperNode* const p) { parent = p; }
-
-  private:
-    HelperNode* volatile parent;
-  };
-  
-  class HelperNode : public TreeNode {
-  public:    
     
     inline void initializeSynchronized(const bool sense) {
       flags.bits.winnerAlreadyReachedThisPoint = not sense;
@@ -78,17 +73,9 @@ namespace ConstTree {
     friend class Barrier;
   };
   
-  /**
-   * Defines the properties which define the identity of a participant in the
-   * tree, declared sparatly to be able to do stack allocation of Participants.
-   */
-  class ParticipantId {
-    HelperNode* parent;
-  };
-  
   class Barrier;
   
-  class Participant : public TreeNode {
+  class Participant : public CacheLineAligned {
   public:
     inline Participant(Barrier* const phaser);
     
@@ -119,19 +106,16 @@ namespace ConstTree {
     
   private:
     
-    //inline void doOptionalYield() const {
-    //	if (DO_YIELD) {
-    //		pthread_yield();
-    //	}
-    //}
-
     inline void awaitNextPhase() const {
-      while ((*waitFlag) != sense)
-      	/*doOptionalYield()*/ ;
+      WAIT_POLICY waiter(waitFlag);
+      while (atomic_load<ORDER_ACQUIRE>(waitFlag) != sense) {
+        waiter.wait();
+      }
     }
     
     bool resumed;
-    int  leaveId; // leave ids start with 1, since this allows an easy recognition of the next insert node
+    int  leaveId;   // leave ids start with 1, in the order of registration
+    int  nodeIndex; // the index of the leave in the implicit tree
 
     bool sense;
     volatile bool* waitFlag;
@@ -139,21 +123,28 @@ namespace ConstTree {
     Barrier* const phaser;
     
     friend class Barrier;
-    friend class FreeParticipant;
-    friend class TreeNode;
   };
   
-  class Barrier {
+  class Barrier : public CacheLineAligned {
   public:
-    Barrier(const size_t)
+    Barrier(const size_t numParticipants)
     : lastleaveId(0),
-      lastTreeNode(NULL),      
+      numParticipants(numParticipants),
+      helperNodes(new CacheLinePadded<HelperNode>[numParticipants > 1 ? numParticipants - 1 : 1]),
       evenIteration(true),
       sense(true),
       waitFlag(false)
     {
       assert(sizeof(HelperNodeAtomicState) == sizeof(int));
-      lock_init(&insertAndDropLock, NULL);
+      
+      // nobody reached any node yet
+      for (size_t i = 0; i + 1 < numParticipants; i++) {
+        helperNodes[i].value.initializeSynchronized(sense);
+      }
+    }
+    
+    ~Barrier() {
+      delete[] helperNodes;
     }
     
     inline void add(Participant* const participant) {
@@ -161,11 +152,11 @@ namespace ConstTree {
       participant->sense         = sense;
       participant->waitFlag      = &waitFlag;
       
-      lock_acquire(&insertAndDropLock);
+      const int leaveId = getNextLeaveId();
+      assert((size_t)leaveId <= numParticipants);
       
-      insertNewIntoTree(participant);
-      
-      lock_release(&insertAndDropLock);
+      participant->setLeaveId(leaveId);
+      participant->nodeIndex = (int)numParticipants - 2 + leaveId;
     }    
     
     inline void finalize_initialization() {}
@@ -176,81 +167,22 @@ namespace ConstTree {
       sense = !sense;
     }
     
-    
-    inline void insertNewIntoTree(Participant* const participant) {
-      TreeNode* const insertNode = getNextInsertNode(lastTreeNode);
-      
-      participant->setLeaveId(getNextLeaveId());
-      
-      // if there is nothing yet, insert first node
-      if (insertNode == NULL) {
-        participant->setParent(NULL);
-        // participant->insertLockIfInsertNode = &insertAndDropLock;
-        lastTreeNode = participant;
-        return;
-      }
-      
-      // the general case, when there is already some tree
-      
-      
-      HelperNode* const helper = new HelperNode();
-      helper->setParent(insertNode->getParent());
-            
-      // use a strategy of over-announcement, i.e., insert the helper indicating
-      // that the new node already synchronized. This will allow all other nodes
-      // in the related subtree to announce synchronization consitently.
-      // It does not pose problems since it will not imply final synchronization,
-      // since the adding participant can not have synchronized yet.
-      // There is no spawn-clocked/'spawn with phaser' after a resume(), which is a Good Thing(TM)
-      helper->initializeSynchronized(participant->sense);
-      
-      // Not modify the tree
-      // this could be a raise, but it is protected by the insertLock
-      insertNode->setParent(helper);
-      
-      
-      // the participant is the least important item, and can be handled now.
-      // using stack-allocation, the thread exacuting this code here,
-      // should allways be the participant anyway
-      participant->setParent(helper);
-      
-      lastTreeNode = participant;
-    }
-    
-    inline TreeNode* getNextInsertNode(Participant* const lastNode) const {
-      if (!lastNode) {
-        return NULL;
-      }
-      
-      TreeNode* result = lastNode;
-      
-      int tmp = lastNode->getLeaveId();
-      
-      while ((tmp & 1) == 0) {  // while(tmp % 2 == 0)
-      	//printf("getNextInsertNode: tmp=%d, result=%p\n", tmp, result);
-      	assert(result != NULL);
-        result = result->getParent();
-        tmp >>= 1;            // tmp /= 2;
-      }
-      
-      return result;
-    }
-    
     inline int getNextLeaveId() {
-      //int old = lastleaveId;
-      int result = atomic_add_and_fetch(&lastleaveId, 1);
-      //printf("NextLeaveId: %d, old=%d, new=%d\n", result, old, lastleaveId);
-      return result;
+      return atomic_add_and_fetch(&lastleaveId, 1);
     }
     
-    int                       lastleaveId; // leave id's start counting with 1
-    Participant*     volatile lastTreeNode;
-    lock_t insertAndDropLock;
+    int                             lastleaveId; // leave id's start counting with 1
+    const size_t                    numParticipants;
+    CacheLinePadded<HelperNode>* const helperNodes; // the inner nodes of the implicit tree, the root at index 0
     
     // global flags
     volatile bool evenIteration;
     volatile bool sense;
+    
+    // spun on by all participants
+    CACHE_LINE_PAD(padding0);
     volatile bool waitFlag;
+    CACHE_LINE_PAD(padding1);
     
     friend class Participant;
   };
@@ -270,10 +202,6 @@ namespace ConstTree {
   /**
    * Propagate the resume up the tree.
    * Resume is always called on the leave node i.e. participant node first.
-   *
-   * REM we need to acquire the insert/drop lock if we are the insert node.
-   *     The insert node with the look does not have to be the participant node,
-   *     i.e. it might be one of the helper nodes up the tree
    */
   bool Participant::resume() {
     // do nothing if we already resumed, or don't signal at all
@@ -283,19 +211,18 @@ namespace ConstTree {
     // ok, now we resumed this node
     resumed = true;
     
-    // the hard part...
-//#warning do we still need that lock???
-    //lock_t* const lock = insertLockIfInsertNode;
-    //if (lock) lock_acquire(lock);
+    const bool sense = getSense();
     
-    const bool sense         = getSense();
-
-          HelperNode* node   = getParent();
+    CacheLinePadded<HelperNode>* const nodes = phaser->helperNodes;
+    int index = nodeIndex;
         
     bool propagateResumeFurther   = true;
     HelperNodeAtomicState currentFlags;
     
-    while (node && propagateResumeFurther) {
+    while (index > 0 && propagateResumeFurther) {
+      index = (index - 1) >> 1;  // the parent
+      HelperNode* const node = &nodes[index].value;
+      
       bool compareAndSwap_failed = true;
       currentFlags = node->flags;
       
@@ -305,40 +232,30 @@ namespace ConstTree {
         propagateResumeFurther = setResume(&newFlags,
                                            sense);
         
-        // now the new flags are prepared, and we can try to install them
-        HelperNodeAtomicState oldFlags;
-        oldFlags.value = atomic_compare_and_swap(&node->flags.value, currentFlags.value, newFlags.value);
-        
-        if (oldFlags.value == currentFlags.value) {
-          // CAS was sucessful, and we can exit the loop
-          compareAndSwap_failed = false;
-        }
-        else {
-          // lets try again, but use reuse the read value for next round
-          currentFlags = oldFlags;
-        }
+        // now the new flags are prepared, and we can try to install them,
+        // on failure currentFlags holds the read value for the next round
+        compareAndSwap_failed = not atomic_compare_exchange<ORDER_ACQ_REL>(
+                                  &node->flags.value, currentFlags.value, newFlags.value);
       }
       while (compareAndSwap_failed);
-      
-      node = node->getParent();
     }
     
     if (propagateResumeFurther) {
       notifyParticipants();
     }
     
-    //if (lock) lock_release(lock);
     return propagateResumeFurther;      
   }
   
   Participant::Participant(Barrier* const phaser)
-  : resumed(false), phaser(phaser) /*, insertLockIfInsertNode(NULL)*/ {
+  : resumed(false), phaser(phaser) {
     phaser->add(this);
   }
     
   void Participant::notifyParticipants() const {
     phaser->advanceFlags();
-    (*waitFlag) = sense;
+    atomic_store<ORDER_RELEASE>(waitFlag, sense);
+    WAIT_POLICY::wake(waitFlag);
   }
   
 }
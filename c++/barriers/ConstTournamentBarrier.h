@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ * Implements the tournament barrier algorithm of Hensgen, Finkel & Manber
+ * in the variant presented in \cite{103729}
+ * Mellor-Crummey, John M. & Scott, Michael L.: 
+ *  Algorithms for Scalable Synchronization on Shared-Memory Multiprocessors
+ *  In: ACM Trans. Comput. Syst. , Vol. 9 , Nr. 1 New York, NY, USA: ACM (1991).
+ *
+ * The winner of every round is statically determined, so the losers only
+ * have to signal their single opponent, resulting in O(P) remote writes
+ * per episode.
+ */
+
+#include <cstddef>
+#include "../misc/atomic.h"
+#include "../misc/misc.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
+
+#ifndef BARRIER
+  #define BARRIER ConstTournamentBarrier<NUM_PARTICIPANTS, LOG2_NUM_PARTICIPANTS>
+#endif
+
+#ifndef PARTICIPANT
+  #define PARTICIPANT ConstTournamentBarrier<NUM_PARTICIPANTS, LOG2_NUM_PARTICIPANTS>::Participant
+#endif
+
+template<int NumParticipants, int Rounds>
+class ConstTournamentBarrier {
+public:
+  
+  enum Role {
+    WINNER,
+    LOSER,
+    BYE,
+    CHAMPION,
+    DROPOUT
+  };
+  
+  class Participant : public CacheLineAligned {
+  public:
+    Participant(ConstTournamentBarrier* barrier): sense(true) {
+      const int id = barrier->add(this);
+      initialize(id);
+    }
+    
+    inline bool resume() const {return false;}
+    inline bool next() {
+      return barrier();
+    }
+    
+    inline bool barrier() {
+      int round = 1;
+      
+      // arrival: move up the tournament until we lose, or won all rounds
+      for (; round <= Rounds; round++) {
+        volatile bool* const flag = &flags[round].value;
+        
+        if (roles[round] == LOSER) {
+          signal(opponent[round]);
+          await(flag);
+          break;
+        }
+        else if (roles[round] == WINNER) {
+          await(flag);
+        }
+        else if (roles[round] == CHAMPION) {
+          await(flag);
+          signal(opponent[round]);
+          break;
+        }
+        // BYE: nothing to do in this round
+      }
+      
+      // wakeup: release all the opponents we have beaten on the way up
+      for (round--; round > 0; round--) {
+        if (roles[round] == WINNER) {
+          signal(opponent[round]);
+        }
+      }
+      
+      sense = !sense;
+      
+      // the champion is the master
+      return isMaster;
+    }
+    
+    void free() {}
+    
+  private:
+    inline void signal(volatile bool* const flag) const {
+      atomic_store<ORDER_RELEASE>(flag, sense);
+      WAIT_POLICY::wake(flag);
+    }
+    
+    inline void await(volatile bool* const flag) const {
+      WAIT_POLICY waiter(flag);
+      while (atomic_load<ORDER_ACQUIRE>(flag) != sense) {
+        waiter.wait();
+      }
+    }
+    
+    /**
+     * The roles only depend on the id of the participant and are fixed for
+     * the lifetime of the barrier.
+     */
+    void initialize(const int id) {
+      isMaster = (id == 0);
+      
+      for (int round = 0; round <= Rounds; round++) {
+        flags[round].value = false;
+        opponent[round]   = &dummy;
+        
+        const int roundDistance = 1 << round;        // 2^k
+        const int halfDistance  = roundDistance >> 1; // 2^(k-1)
+        
+        if (round == 0) {
+          roles[round] = DROPOUT;
+        }
+        else if (id % roundDistance == halfDistance) {
+          roles[round] = LOSER;
+        }
+        else if (id % roundDistance == 0) {
+          if (id + halfDistance >= NumParticipants) {
+            roles[round] = BYE;
+          }
+          else if (id == 0 && roundDistance >= NumParticipants) {
+            roles[round] = CHAMPION;
+          }
+          else {
+            roles[round] = WINNER;
+          }
+        }
+        else {
+          // we already lost in an earlier round, this one is never reached
+          roles[round] = BYE;
+        }
+      }
+    }
+    
+    // every flag is written by exactly one opponent
+    CacheLinePadded<volatile bool> flags[Rounds + 1];
+    
+    Role           roles[Rounds + 1];
+    volatile bool* opponent[Rounds + 1];
+    
+    bool sense;
+    volatile bool dummy;
+    bool isMaster;
+    
+    friend class ConstTournamentBarrier;
+  };
+  
+  
+  ConstTournamentBarrier(const size_t) : next_id(-1) {}
+  
+  /**
+   * Ensure that all invariants are fulfilled.
+   */
+  void finalize_initialization() {
+    // assign opponents, the roles are already set by the participants
+    for (int i = 0; i < NumParticipants; i++) {
+      Participant* const p = participants[i];
+      
+      for (int round = 1; round <= Rounds; round++) {
+        const int halfDistance = 1 << (round - 1);
+        
+        switch (p->roles[round]) {
+          case LOSER:
+            p->opponent[round] = &participants[i - halfDistance]->flags[round].value;
+            break;
+          case WINNER:
+          case CHAMPION:
+            p->opponent[round] = &participants[i + halfDistance]->flags[round].value;
+            break;
+          default:
+            break;
+        }
+      }
+    }
+  }
+  
+  void free() {}
+    
+private:
+  int add(Participant* const participant) {
+    const int id = atomic_add_and_fetch(&next_id, 1);
+    participants[id] = participant;
+    return id;
+  }
+  
+  int next_id;
+
+  Participant* participants[NumParticipants];
+    
+};
@@ -32,6 +32,9 @@
 #include "../misc/assert.h"
 #include "../misc/atomic.h"
 #include "../misc/lock.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
+#include "../misc/stats.h"
 
 #include <vector>
 #include <limits.h>
@@ -47,7 +50,7 @@ namespace Habanero {
   //const static int busyWaitCount = 100000;
   
   // For SIGNAL
-  class SyncVar1 {
+  class SyncVar1 : public CacheLineAligned {
   public:
     SyncVar1(const int sigPhase, const int sigCycle,
              const Mode mode)
@@ -65,7 +68,7 @@ namespace Habanero {
   
   
   // For WAIT
-  class SyncVar2 {
+  class SyncVar2 : public CacheLineAligned {
   public:
     volatile int waitPhase;
     int waitCycle;
@@ -116,7 +119,7 @@ namespace Habanero {
     SyncVar2* s2;
   };
 
-class Phaser {
+class Phaser : public CacheLineAligned {
 public:
   Phaser(const size_t)
   : initialParticipant(NULL), masterMode(TRANSMIT),
@@ -154,11 +157,16 @@ public:
     assert(s1 == NULL || s1->isResumed); // Signal is necessary before wait.
     
     s2->mID++;
+    stats_add(STAT_EPISODES);
 		
     s2->isMaster = (s2->prevMSP <= s2->waitPhase && mSigPhase <= s2->waitPhase
                     && s2->mode == masterMode
                     && atomic_compare_and_swap_bool(&masterID, s2->mID - 1, s2->mID));
     
+    if (s2->isMaster) {
+      stats_add(STAT_MASTER_ELECTIONS);
+    }
+    
 		//if (s2->mode == SINGLE) // do not support single ATM
 		//	s2.loc = null;
     
@@ -176,9 +184,11 @@ public:
 				//	loc_of_master = s2.loc;
         
 				mSigPhase++;
+        WAIT_POLICY::wake(&mSigPhase);
         
 				if (!atomic_compare_and_swap_bool((int*)&sCastID, mSigPhase - 1, mSigPhase))
 					; //_notifyAllWorkersOnS2(s2);
+        WAIT_POLICY::wake(&sCastID);
           
       }
       else {
@@ -204,10 +214,12 @@ public:
         // If a master blocks at point X, other wait-only activity may
         // reach here
         // as a new master. Next while-loop is to block such new master.
+        WAIT_POLICY waiter(&sCastID);
         while (sCastID < mSigPhase)
-          ;
+          waiter.wait();
         
         mSigPhase += delta;
+        WAIT_POLICY::wake(&mSigPhase);
         
         // point X
         if (!atomic_compare_and_swap_bool((int*)&sCastID, mSigPhase - delta, mSigPhase)) {
@@ -218,6 +230,7 @@ public:
           }
           //_notifyAllWorkersOnS2(s2);
         }
+        WAIT_POLICY::wake(&sCastID);
       }
       
 		}
@@ -231,6 +244,7 @@ public:
     
     // Signal to master when bounded phaser
     s2->waitPhase++;
+    WAIT_POLICY::wake(&s2->waitPhase);
   }
   
   inline void finalize_initialization() const {}
@@ -262,8 +276,9 @@ private:
 			for (int i = first; i < size; i++) {
 				SyncVar2* const s2 = lSyncVars2.at(i);
         
+        WAIT_POLICY waiter(&s2->waitPhase);
 				while (!s2->isDropped && s2->waitPhase <= mSigPhase)
-					;
+					waiter.wait();
 				if (!s2->isDropped) {
 					const int s2WaitP = s2->waitPhase;
 					if (s2WaitP < min)
@@ -332,10 +347,12 @@ private:
       
     s1->sigPhase++;
 		s1->isResumed = true;
+    WAIT_POLICY::wake(&s1->sigPhase);
   }
   
   void _waitForMasterSignal(SyncVar2* const s2) const {
 		bool done = false;
+    WAIT_POLICY waiter(&mSigPhase);
     
 		while (!done) {
 			//for (int j = 0; j < busyWaitCount; j++) {
@@ -346,6 +363,8 @@ private:
 				}
 			//}
       
+      waiter.wait();
+      
 			/*if (!done) {
 				while (sCastID < s2->waitPhase)
 					;
@@ -440,6 +459,7 @@ private:
     
 		if (s1 != NULL && !s1->isDropped) {
 			s1->isDropped = true;
+      WAIT_POLICY::wake(&s1->sigPhase);
 			p->dropPhaser();
 			actIsDropped = true;
 		}
@@ -515,12 +535,15 @@ private:
 				mWaitPhase++;
 				
 				mSigPhase++;
+        WAIT_POLICY::wake(&mSigPhase);
         
 				if (!atomic_compare_and_swap_bool((int*)&sCastID, mSigPhase - 1, mSigPhase))
 					; //_notifyAllWorkersOnS2(s2);
+        WAIT_POLICY::wake(&sCastID);
 			}
       
 			s2->isDropped = true;
+      WAIT_POLICY::wake(&s2->waitPhase);
       
 			if (!actIsDropped) {
         p->dropPhaser();
@@ -579,8 +602,9 @@ private:
 			for (int i = first; i < size; i++) {
 				SyncVar1* const s1 = lSyncVars1.at(i);
         
+        WAIT_POLICY waiter(&s1->sigPhase);
 				while (!s1->isDropped && s1->sigPhase <= mWaitPhase)
-					;
+					waiter.wait();
 				if (!s1->isDropped) {
 					int s1SigP = s1->sigPhase;
 					if (s1SigP < min)
@@ -597,10 +621,15 @@ private:
   int swCounter;
   int snglCounter;
   
+  // spun on by all waiting participants
+  CACHE_LINE_PAD(padding0);
   volatile int mWaitPhase;
   volatile int mSigPhase;
+  CACHE_LINE_PAD(padding1);
   
+  // every waiting participant competes for it with a CAS
   int masterID;
+  CACHE_LINE_PAD(padding2);
   
   int minSigP;
   
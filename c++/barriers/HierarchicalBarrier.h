@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ * Composes two barriers into a two-level hierarchy: participants are grouped
+ * by the CPU package (or L3 cache) they register on, every group
+ * synchronizes on its own InnerBarrier, and only one representative per
+ * group takes part in the OuterBarrier. Thus, the cross-socket traffic is
+ * reduced to the single representative per group.
+ *
+ * Group sizes are only known after all participants registered, thus,
+ * the inner and outer barriers are created in finalize_initialization(),
+ * and need to accept their number of participants at runtime.
+ */
+
+#ifndef BARRIER
+  #define BARRIER     HierarchicalBarrier<SpinningCentralBarrier, Participant, SpinningDisseminationBarrier, SpinningDisseminationBarrier::Participant>
+#endif
+
+#ifndef PARTICIPANT
+  #define PARTICIPANT HierarchicalBarrier<SpinningCentralBarrier, Participant, SpinningDisseminationBarrier, SpinningDisseminationBarrier::Participant>::Participant
+#endif
+
+// the default composition
+#include "SpinningCentralBarrier.h"
+#include "SpinningDisseminationBarrier.h"
+
+#include <cstddef>
+#include <vector>
+#include "../misc/atomic.h"
+#include "../misc/misc.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
+#include "../misc/lock.h"
+#include "../misc/topology.h"
+
+/**
+ * The topology level at which participants are grouped,
+ * 0 groups by physical package, any other value by the cache of that level.
+ */
+#ifndef HIERARCHICAL_GROUP_CACHE_LEVEL
+  #define HIERARCHICAL_GROUP_CACHE_LEVEL 0
+#endif
+
+template<class InnerBarrier, class InnerParticipant, class OuterBarrier, class OuterParticipant>
+class HierarchicalBarrier {
+public:
+  
+  class Participant;
+  
+  class Group : public CacheLineAligned {
+  public:
+    Group(const int domain) : domain(domain), barrier(NULL), release(false) {}
+    
+    const int domain;
+    
+    InnerBarrier*             barrier;
+    std::vector<Participant*> members;
+    
+    // the representative of the group releases all other members by this flag
+    CACHE_LINE_PAD(padding0);
+    volatile bool release;
+    CACHE_LINE_PAD(padding1);
+  };
+  
+  class Participant : public CacheLineAligned {
+  public:
+    Participant(HierarchicalBarrier* const barrier)
+    : inner(NULL), outer(NULL), group(NULL), sense(true) {
+      barrier->add(this, HierarchicalBarrier::currentDomain());
+    }
+    
+    inline bool resume() const {return false;}
+    inline bool next() {
+      return barrier();
+    }
+    
+    inline bool barrier() {
+      bool isMaster = false;
+      
+      inner->barrier();
+      
+      if (outer) {
+        // we are the representative, synchronize with all other groups
+        isMaster = outer->barrier();
+        atomic_store<ORDER_RELEASE>(&group->release, sense);
+        WAIT_POLICY::wake(&group->release);
+      }
+      else {
+        WAIT_POLICY waiter(&group->release);
+        while (atomic_load<ORDER_ACQUIRE>(&group->release) != sense) {
+          waiter.wait();
+        }
+      }
+      
+      sense = !sense;
+      return isMaster;
+    }
+    
+    /**
+     * Deletes the participants of the inner and outer barrier, which have
+     * to be freed by their barriers first.
+     */
+    void free() {
+      delete inner;
+      delete outer;
+      
+      inner = NULL;
+      outer = NULL;
+    }
+    
+  private:
+    InnerParticipant* inner;
+    OuterParticipant* outer;   // only set for the representative of a group
+    Group*            group;
+    
+    bool sense;
+    
+    friend class HierarchicalBarrier;
+  };
+  
+  HierarchicalBarrier(const size_t) : outerBarrier(NULL) {
+    lock_init(&registrationLock, 0);
+  }
+  
+  /**
+   * Creates the barriers for all groups and the barrier connecting them,
+   * all participants have to be registered at this point.
+   */
+  void finalize_initialization() {
+    outerBarrier = new OuterBarrier(groups.size());
+    
+    for (size_t g = 0; g < groups.size(); g++) {
+      Group* const group = groups[g];
+      group->barrier = new InnerBarrier(group->members.size());
+      
+      for (size_t i = 0; i < group->members.size(); i++) {
+        Participant* const p = group->members[i];
+        p->inner = new InnerParticipant(group->barrier);
+        
+        if (i == 0) {
+          p->outer = new OuterParticipant(outerBarrier);
+        }
+      }
+      
+      group->barrier->finalize_initialization();
+    }
+    
+    outerBarrier->finalize_initialization();
+  }
+  
+  void free() {
+    for (size_t g = 0; g < groups.size(); g++) {
+      if (groups[g]->barrier) {
+        groups[g]->barrier->free();
+      }
+    }
+    
+    if (outerBarrier) {
+      outerBarrier->free();
+    }
+    
+    for (size_t g = 0; g < groups.size(); g++) {
+      Group* const group = groups[g];
+      
+      for (size_t i = 0; i < group->members.size(); i++) {
+        group->members[i]->free();
+      }
+      
+      delete group->barrier;
+      delete group;
+    }
+    groups.clear();
+    
+    delete outerBarrier;
+    outerBarrier = NULL;
+  }
+  
+  inline size_t numberOfGroups() const { return groups.size(); }
+  
+private:
+  
+  /**
+   * @return the topology domain of the CPU the calling thread runs on,
+   *         or -1 if the topology is unknown
+   */
+  static int currentDomain() {
+    const int cpu = topology_current_cpu();
+    if (HIERARCHICAL_GROUP_CACHE_LEVEL == 0) {
+      return topology_package_id(cpu);
+    }
+    else {
+      return topology_cache_id(cpu, HIERARCHICAL_GROUP_CACHE_LEVEL);
+    }
+  }
+  
+  void add(Participant* const participant, const int domain) {
+    lock_acquire(&registrationLock);
+    
+    Group* group = NULL;
+    for (size_t g = 0; g < groups.size(); g++) {
+      if (groups[g]->domain == domain) {
+        group = groups[g];
+        break;
+      }
+    }
+    
+    if (group == NULL) {
+      group = new Group(domain);
+      groups.push_back(group);
+    }
+    
+    group->members.push_back(participant);
+    participant->group = group;
+    
+    lock_release(&registrationLock);
+  }
+  
+  std::vector<Group*> groups;
+  OuterBarrier*       outerBarrier;
+  
+  lock_t registrationLock;
+};
@@ -25,6 +25,8 @@
 #include <pthread.h>
 #include "../misc/atomic.h"
 #include "../misc/misc.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
 
 #ifndef BARRIER
   #define BARRIER SpinningCentralBarrier
@@ -38,7 +40,7 @@
 
 class Participant;
 
-class SpinningCentralBarrier {
+class SpinningCentralBarrier : public CacheLineAligned {
 public:
   
   SpinningCentralBarrier(int number_of_participants)
@@ -48,22 +50,24 @@ public:
   
   inline void finalize_initialization() {}
   
+  void free() {}
+  
   bool do_barrier() {
-    const bool sense   = arrival_sense;
-    const int  arrived = atomic_add_and_fetch((int*)&arrived_participants, 1);
+    const bool sense   = atomic_load<ORDER_RELAXED>(&arrival_sense);
+    const int  arrived = atomic_fetch_add<ORDER_ACQ_REL>(&arrived_participants, 1) + 1;
     
     if (arrived == number_of_participants) {
-      arrived_participants = 0;
-      arrival_sense = !arrival_sense;
+      atomic_store<ORDER_RELAXED>(&arrived_participants, 0);
+      atomic_store<ORDER_RELEASE>(&arrival_sense, !sense);
+      WAIT_POLICY::wake(&arrival_sense);
       return true;
     }
     else {
 
       // spin until the barrier is completed
-      while (sense == arrival_sense) {
-        //if (DO_YIELD) {
-        //  pthread_yield();
-        //}
+      WAIT_POLICY waiter(&arrival_sense);
+      while (sense == atomic_load<ORDER_ACQUIRE>(&arrival_sense)) {
+        waiter.wait();
       }
       
       return false;
@@ -73,9 +77,12 @@ public:
 private:
   const    int  number_of_participants;
   
+  // spun on by all participants, written once per episode
   volatile bool arrival_sense;
+  CACHE_LINE_PAD(padding0);
+  
   volatile int  arrived_participants;
-
+  CACHE_LINE_PAD(padding1);
 };
 
 class Participant {
@@ -26,6 +26,8 @@
 #include "../misc/atomic.h"
 #include "../misc/misc.h"
 #include "../misc/lock.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
 
 #ifndef BARRIER
   #define BARRIER SpinningCentralBarrier
@@ -39,7 +41,7 @@
 
 class Participant;
 
-class SpinningCentralBarrier {
+class SpinningCentralBarrier : public CacheLineAligned {
 public:
   
   SpinningCentralBarrier(int number_of_participants)
@@ -52,7 +54,7 @@ public:
   inline void finalize_initialization() {}
   
   bool do_barrier() {
-    const bool sense   = arrival_sense;
+    const bool sense   = atomic_load<ORDER_RELAXED>(&arrival_sense);
     
     lock_acquire(&lock);
     arrived_participants = arrived_participants + 1;
@@ -60,16 +62,16 @@ public:
     lock_release(&lock);
     
     if (arrived == number_of_participants) {
-      arrived_participants = 0;
-      arrival_sense = !arrival_sense;
+      atomic_store<ORDER_RELAXED>(&arrived_participants, 0);
+      atomic_store<ORDER_RELEASE>(&arrival_sense, !sense);
+      WAIT_POLICY::wake(&arrival_sense);
       return true;
     }
     else {
       // spin until the barrier is completed
-      while (sense == arrival_sense) {
-        //if (DO_YIELD) {
-        //  pthread_yield();
-        //}
+      WAIT_POLICY waiter(&arrival_sense);
+      while (sense == atomic_load<ORDER_ACQUIRE>(&arrival_sense)) {
+        waiter.wait();
       }
       
       return false;
@@ -79,11 +81,13 @@ public:
 private:
   const    int  number_of_participants;
   
+  // spun on by all participants, written once per episode
   volatile bool arrival_sense;
+  CACHE_LINE_PAD(padding0);
+  
   volatile int  arrived_participants;
-
   lock_t  lock;
-  
+  CACHE_LINE_PAD(padding1);
 };
 
 
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *
+ * A dynamic central barrier like SpinningCentralDBarrier, but the arrival
+ * counter is sharded over several cache lines, in the spirit of a scalable
+ * non-zero indicator. Participants are assigned to a shard by the L2 cache
+ * of the CPU they register on. Only the last participant arriving in a shard
+ * increments the root counter, and the participant completing the root
+ * releases every shard by its own sense flag.
+ *
+ * As for SpinningCentralDBarrier, register and drop are not allowed to race
+ * with a barrier episode in which the participant takes part.
+ */
+
+#include <stddef.h>
+#include <pthread.h>
+#include "../misc/atomic.h"
+#include "../misc/misc.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
+#include "../misc/topology.h"
+
+#ifndef BARRIER
+  #define BARRIER SpinningCentralShardedBarrier
+#endif
+
+#ifndef PARTICIPANT
+  #define PARTICIPANT Participant
+#endif
+
+#ifndef CENTRAL_BARRIER_SHARDS
+  #define CENTRAL_BARRIER_SHARDS 8
+#endif
+
+
+class Participant;
+
+class SpinningCentralShardedBarrier : public CacheLineAligned {
+public:
+  
+  /**
+   * The arrival counter of a group of participants,
+   * the sense flag they spin on is kept on a separate cache line.
+   */
+  class Shard {
+  public:
+    Shard() : number_of_participants(0), arrived_participants(0), arrival_sense(false) {}
+    
+    volatile int  number_of_participants;
+    volatile int  arrived_participants;
+    
+    CACHE_LINE_PAD(padding0);
+    volatile bool arrival_sense;
+    CACHE_LINE_PAD(padding1);
+  };
+  
+  SpinningCentralShardedBarrier(const int)
+    : active_shards(0),
+      arrived_shards(0),
+      next_shard(0),
+      num_cpus(0),
+      cpu_shards(NULL) {
+    mapCpusToShards();
+  }
+  
+  ~SpinningCentralShardedBarrier() {
+    delete[] cpu_shards;
+  }
+  
+  inline void finalize_initialization() {}
+  
+  bool do_barrier(Shard* const shard) {
+    const bool sense   = atomic_load<ORDER_RELAXED>(&shard->arrival_sense);
+    const int  arrived = atomic_fetch_add<ORDER_ACQ_REL>(&shard->arrived_participants, 1) + 1;
+    
+    if (arrived == shard->number_of_participants) {
+      // we are the last one of the shard, reset it and combine at the root
+      atomic_store<ORDER_RELAXED>(&shard->arrived_participants, 0);
+      
+      const int arrivedShards = atomic_fetch_add<ORDER_ACQ_REL>(&arrived_shards, 1) + 1;
+      
+      if (arrivedShards == active_shards) {
+        atomic_store<ORDER_RELAXED>(&arrived_shards, 0);
+        
+        for (int i = 0; i < CENTRAL_BARRIER_SHARDS; i++) {
+          atomic_store<ORDER_RELEASE>(&shards[i].arrival_sense, !sense);
+          WAIT_POLICY::wake(&shards[i].arrival_sense);
+        }
+        return true;
+      }
+    }
+    
+    // spin until the barrier is completed
+    WAIT_POLICY waiter(&shard->arrival_sense);
+    while (sense == atomic_load<ORDER_ACQUIRE>(&shard->arrival_sense)) {
+      waiter.wait();
+    }
+    
+    return false;
+  }
+
+private:
+  inline Shard* _register() {
+    Shard* const shard = &shards[selectShard()];
+    
+    if (atomic_add_and_fetch((int*)&shard->number_of_participants, 1) == 1) {
+      atomic_add_and_fetch((int*)&active_shards, 1);
+    }
+    
+    return shard;
+  }
+  
+  inline void _drop(Shard* const shard) {
+    if (atomic_add_and_fetch((int*)&shard->number_of_participants, -1) == 0) {
+      atomic_add_and_fetch((int*)&active_shards, -1);
+    }
+  }
+  
+  /**
+   * Participants sharing an L2 cache share a shard, without topology
+   * information, the shards are assigned round-robin.
+   */
+  inline int selectShard() {
+    const int cpu = topology_current_cpu();
+    
+    if (cpu >= 0 && cpu < num_cpus && cpu_shards[cpu] >= 0) {
+      return cpu_shards[cpu];
+    }
+    
+    return (atomic_add_and_fetch(&next_shard, 1) - 1) % CENTRAL_BARRIER_SHARDS;
+  }
+  
+  /**
+   * The L2 ids are not necessarily dense, e.g., they can be the first CPU
+   * sharing the cache. Thus, the distinct ids are numbered in the order of
+   * the CPUs, so that neighboring caches get different shards. This reads
+   * sysfs once here, instead of on every registration.
+   */
+  inline void mapCpusToShards() {
+    const int numCpus = topology_num_cpus();
+    if (numCpus <= 0) {
+      return;
+    }
+    
+    int* const cacheIds = new int[numCpus];
+    cpu_shards = new int[numCpus];
+    int numCaches = 0;
+    
+    for (int cpu = 0; cpu < numCpus; cpu++) {
+      cacheIds[cpu]   = topology_cache_id(cpu, 2);
+      cpu_shards[cpu] = -1;
+      
+      if (cacheIds[cpu] == -1) {
+        continue;
+      }
+      
+      for (int other = 0; other < cpu; other++) {
+        if (cacheIds[other] == cacheIds[cpu]) {
+          cpu_shards[cpu] = cpu_shards[other];
+          break;
+        }
+      }
+      
+      if (cpu_shards[cpu] == -1) {
+        cpu_shards[cpu] = numCaches % CENTRAL_BARRIER_SHARDS;
+        numCaches++;
+      }
+    }
+    
+    delete[] cacheIds;
+    num_cpus = numCpus;
+  }
+  
+  volatile int active_shards;
+  
+  CACHE_LINE_PAD(padding0);
+  volatile int arrived_shards;
+  CACHE_LINE_PAD(padding1);
+  
+  int next_shard;
+  
+  // the shard of each CPU, -1 if its L2 cache is unknown
+  int  num_cpus;
+  int* cpu_shards;
+  
+  Shard shards[CENTRAL_BARRIER_SHARDS];
+
+  friend class Participant;
+};
+
+class Participant {
+public:
+  Participant(SpinningCentralShardedBarrier* const barrier) : _barrier(barrier), dropped(false) {
+    shard = _barrier->_register();
+  }
+  
+  ~Participant() {
+    drop();
+  }
+  
+  inline bool resume() const {return false;}
+  
+  inline bool next() {
+    return barrier();
+  }
+  
+  inline void drop() {
+    if (not dropped) {
+      dropped = true;
+      _barrier->_drop(shard);
+    }
+  }
+  
+  inline bool barrier() const {
+    return _barrier->do_barrier(shard);
+  }
+  
+private:
+  SpinningCentralShardedBarrier* const _barrier;
+  SpinningCentralShardedBarrier::Shard* shard;
+  volatile bool dropped;
+};
@@ -30,6 +30,8 @@
 #include <cstddef>
 #include <cstdio>
 #include "../misc/atomic.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
 
 #ifndef BARRIER
   #define BARRIER SpinningDisseminationBarrier
@@ -42,10 +44,10 @@
 class SpinningDisseminationBarrier {
 public:
   
-  class Participant {
+  class Participant : public CacheLineAligned {
   public:
     Participant(SpinningDisseminationBarrier* const barrier)
-     : flags(new volatile bool*[2]), partner(new volatile bool**[2]),
+     : flags(new CacheLinePadded<volatile bool>*[2]), partner(new volatile bool**[2]),
        parity(0), sense(true), isMaster(false)
     {
       barrier->add(this);
@@ -53,12 +55,13 @@ public:
     
     void initialize(const size_t rounds) {
       this->rounds = rounds;
-      flags[0] = new bool[rounds];
-      flags[1] = new bool[rounds];
+      // every flag is written by a different partner
+      flags[0] = new CacheLinePadded<volatile bool>[rounds];
+      flags[1] = new CacheLinePadded<volatile bool>[rounds];
       
       for (short parity = 0; parity < 2; parity++) {
         for (size_t round = 0; round < rounds; round++) {
-          flags[parity][round] = false;
+          flags[parity][round].value = false;
           //printf("&flags[%zu][%zu] = %p\n", parity, round, &flags[parity][round]);
         }
       }
@@ -74,11 +77,14 @@ public:
     
     inline bool barrier() {
       for (size_t dissemRound = 0; dissemRound < rounds; dissemRound++) {			
-        *partner[parity][dissemRound] = sense;
+        atomic_store<ORDER_RELEASE>(partner[parity][dissemRound], sense);
+        WAIT_POLICY::wake(partner[parity][dissemRound]);
         
-        
-        volatile bool* flag = &flags[parity][dissemRound];
-        while (*flag != sense);
+        volatile bool* flag = &flags[parity][dissemRound].value;
+        WAIT_POLICY waiter(flag);
+        while (atomic_load<ORDER_ACQUIRE>(flag) != sense) {
+          waiter.wait();
+        }
       }
       
       if (parity == 1) {
@@ -105,7 +111,7 @@ public:
       delete[] partner;
     }
     
-    volatile bool** const flags;
+    CacheLinePadded<volatile bool>** const flags;
     volatile bool*** const partner;
     
     short parity;
@@ -137,8 +143,8 @@ public:
     for (size_t i = 0; i < number_of_participants; i++) {     
       for (size_t dissemRounds = 0; dissemRounds < rounds; dissemRounds++) {
         int partnerId = (i + (1 << dissemRounds)) % number_of_participants; //(i + 2^k) mod P
-        participants[i]->partner[0][dissemRounds] = &participants[partnerId]->flags[0][dissemRounds]; 
-        participants[i]->partner[1][dissemRounds] = &participants[partnerId]->flags[1][dissemRounds];
+        participants[i]->partner[0][dissemRounds] = &participants[partnerId]->flags[0][dissemRounds].value; 
+        participants[i]->partner[1][dissemRounds] = &participants[partnerId]->flags[1][dissemRounds].value;
       }
     }
   }
@@ -146,8 +152,8 @@ public:
 
   
   void free() {
-    for (size_t round = 0; round < rounds; round++) {
-      participants[round]->free();
+    for (size_t i = 0; i < number_of_participants; i++) {
+      participants[i]->free();
     }
     
     delete[] participants;
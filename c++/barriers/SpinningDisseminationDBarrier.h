@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * A dynamic variant of the dissemination barrier \cite{103729}.
+ *
+ * The partner table is computed once over a fixed number of slots, the size
+ * given to the constructor is the maximal number of concurrent participants.
+ * Each slot records the episodes in which it is occupied: a participant joins
+ * at the episode the other participants are about to start, and leaves at the
+ * episode boundary following its last barrier. A slot which is not occupied
+ * in an episode behaves like a participant which arrived instantly: whoever
+ * waits for its signal instead waits for the signals the empty slot would
+ * have received in the earlier rounds, and records the result in its flags.
+ * Thus, add and drop never block and never have to wait for an episode to
+ * complete.
+ *
+ * Flags are tagged with the episode number instead of using sense reversal,
+ * which makes stale signals of departed participants harmless. Episodes are
+ * counted in 64 bits, thus, they are compared linearly and never wrap.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+#include "../misc/atomic.h"
+#include "../misc/assert.h"
+#include "../misc/misc.h"
+#include "../misc/align.h"
+#include "../misc/wait.h"
+
+#ifndef BARRIER
+  #define BARRIER SpinningDisseminationDBarrier
+#endif
+
+#ifndef PARTICIPANT
+  #define PARTICIPANT SpinningDisseminationDBarrier::Participant
+#endif
+
+// the end of the episodes of a slot, which is still occupied
+#define DISSEMINATION_NEVER INT64_MAX
+
+class SpinningDisseminationDBarrier {
+public:
+  
+  class Slot : public CacheLineAligned {
+  public:
+    Slot() : occupied(0), activeFrom(0), activeUntil(0), nextEpisode(1) {}
+    
+    void initialize(const size_t rounds) {
+      // every flag is written by a different partner
+      flags[0] = new CacheLinePadded<volatile int64_t>[rounds];
+      flags[1] = new CacheLinePadded<volatile int64_t>[rounds];
+      
+      for (size_t round = 0; round < rounds; round++) {
+        flags[0][round].value = 0;
+        flags[1][round].value = 0;
+      }
+    }
+    
+    void free() {
+      delete[] flags[0];
+      delete[] flags[1];
+    }
+    
+    inline bool isActive(const int64_t episode) const {
+      return activeFrom <= episode && episode < activeUntil;
+    }
+    
+    CacheLinePadded<volatile int64_t>* flags[2];
+    
+    volatile int occupied;
+    
+    // the slot takes part in the episodes [activeFrom, activeUntil),
+    // read by the partners in every round, but only written by add and drop
+    volatile int64_t activeFrom;
+    volatile int64_t activeUntil;
+    
+    CACHE_LINE_PAD(padding0);
+    
+    // the episode the occupant runs next, or the one it left at,
+    // written every episode, thus kept apart from the fields above
+    volatile int64_t nextEpisode;
+    
+    CACHE_LINE_PAD(padding1);
+  };
+  
+  class Participant {
+  public:
+    Participant(SpinningDisseminationDBarrier* const barrier)
+    : _barrier(barrier), dropped(false) {
+      slot = barrier->add(&episode);
+    }
+    
+    ~Participant() {
+      drop();
+    }
+    
+    inline bool resume() const {return false;}
+    inline bool next() {
+      return barrier();
+    }
+    
+    inline bool barrier() {
+      const bool result = _barrier->do_barrier(slot, episode);
+      episode++;
+      atomic_store<ORDER_RELEASE>(&_barrier->slots[slot].nextEpisode, episode);
+      return result;
+    }
+    
+    inline void drop() {
+      if (not dropped) {
+        dropped = true;
+        _barrier->drop(slot, episode);
+      }
+    }
+    
+  private:
+    SpinningDisseminationDBarrier* const _barrier;
+    size_t  slot;
+    int64_t episode;
+    bool    dropped;
+  };
+  
+  
+  SpinningDisseminationDBarrier(const size_t number_of_slots)
+  : number_of_slots(number_of_slots),
+    rounds((size_t)ceil(log2(number_of_slots))),
+    slots(new Slot[number_of_slots])
+  {
+    for (size_t i = 0; i < number_of_slots; i++) {
+      slots[i].initialize(rounds);
+    }
+  }
+  
+  inline void finalize_initialization() {}
+  
+  void free() {
+    for (size_t i = 0; i < number_of_slots; i++) {
+      slots[i].free();
+    }
+    
+    delete[] slots;
+  }
+  
+private:
+  /**
+   * @return the latest episode any occupant runs next, slots which were left
+   *         keep the episode they left at, thus it is never behind the
+   *         current episode
+   */
+  int64_t latestEpisode() const {
+    int64_t latest = 1;
+    for (size_t i = 0; i < number_of_slots; i++) {
+      const int64_t nextEpisode = atomic_load<ORDER_ACQUIRE>(&slots[i].nextEpisode);
+      if (nextEpisode > latest) {
+        latest = nextEpisode;
+      }
+    }
+    return latest;
+  }
+  
+  /**
+   * Occupy a free slot, the participant takes part beginning with the
+   * episode the other participants are about to start.
+   *
+   * The others keep running while the slot is chosen. Once the slot is
+   * published as active from start on, nobody completes start or a later
+   * episode without us. Thus, the episodes scanned afterwards do not advance
+   * anymore, and we retry with the latest of them until it is not ahead of
+   * start. Otherwise the others could be two episodes ahead, and the flags
+   * of our parity would already carry their episode.
+   * @return the slot index
+   */
+  size_t add(int64_t* const episode) {
+    size_t id = 0;
+    while (id < number_of_slots
+           && not atomic_compare_and_swap_bool((int*)&slots[id].occupied, 0, 1)) {
+      id++;
+    }
+    
+    if (id == number_of_slots) {
+      fprintf(stderr, "SpinningDisseminationDBarrier: more participants than the %zu slots\n",
+              number_of_slots);
+      exit(1);
+    }
+    
+    Slot* const slot = &slots[id];
+    int64_t start = latestEpisode();
+    
+    atomic_store<ORDER_RELEASE>(&slot->activeFrom,  start);
+    atomic_store<ORDER_RELEASE>(&slot->activeUntil, (int64_t)DISSEMINATION_NEVER);
+    memory_fence();
+    
+    for (int64_t latest = latestEpisode(); latest > start; latest = latestEpisode()) {
+      // the episodes before latest can complete without us again
+      start = latest;
+      atomic_store<ORDER_RELEASE>(&slot->activeFrom, start);
+      memory_fence();
+    }
+    
+    atomic_store<ORDER_RELEASE>(&slot->nextEpisode, start);
+    
+    *episode = start;
+    return id;
+  }
+  
+  void drop(const size_t id, const int64_t episode) {
+    Slot* const slot = &slots[id];
+    slot->activeUntil = episode;
+    atomic_store<ORDER_RELEASE>(&slot->occupied, 0);
+    
+    // the receivers of our signals have to notice that they will not come
+    for (size_t round = 0; round < rounds; round++) {
+      const size_t partner = (id + (1 << round)) % number_of_slots;
+      WAIT_POLICY::wake(&slots[partner].flags[0][round].value);
+      WAIT_POLICY::wake(&slots[partner].flags[1][round].value);
+    }
+  }
+  
+  bool do_barrier(const size_t id, const int64_t episode) {
+    const int parity = (int)(episode & 1);
+    
+    for (size_t round = 0; round < rounds; round++) {
+      const size_t partner = (id + (1 << round)) % number_of_slots;
+      atomic_store<ORDER_RELEASE>(&slots[partner].flags[parity][round].value, episode);
+      WAIT_POLICY::wake(&slots[partner].flags[parity][round].value);
+      
+      await_round(id, round, episode);
+    }
+    
+    return isMaster(id, episode);
+  }
+  
+  /**
+   * The lowest slot active in the completed episode is the master. The
+   * activity of a slot in an episode does not change anymore once the
+   * episode is completed.
+   */
+  bool isMaster(const size_t id, const int64_t episode) const {
+    for (size_t i = 0; i < id; i++) {
+      if (slots[i].isActive(episode)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  
+  /**
+   * Wait for the signal of the given round. If the sender's slot is empty in
+   * this episode, wait for all the signals it would have waited for instead.
+   */
+  void await_round(const size_t id, const size_t round, const int64_t episode) {
+    const int parity = (int)(episode & 1);
+    volatile int64_t* const flag = &slots[id].flags[parity][round].value;
+    const size_t sender = (id + number_of_slots - ((1 << round) % number_of_slots)) % number_of_slots;
+    
+    WAIT_POLICY waiter(flag);
+    while (atomic_load<ORDER_ACQUIRE>(flag) != episode) {
+      waiter.wait();
+      
+      if (not slots[sender].isActive(episode)) {
+        for (size_t r = 0; r < round; r++) {
+          await_round(sender, r, episode);
+        }
+        
+        atomic_store<ORDER_RELEASE>(flag, episode);
+        WAIT_POLICY::wake(flag);
+        return;
+      }
+    }
+  }
+  
+  const size_t number_of_slots;
+  const size_t rounds;
+  
+  Slot* const slots;
+  
+  friend class Participant;
+};
@@ -49,7 +49,9 @@ public:
   
   bool barrier(Participant* const participant);
   
-  void free() {}
+  void free() {
+    InsertionTree<TreeNode>::free();
+  }
   
   inline void finalize_initialization() {}
   
@@ -36,15 +36,17 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <stdint.h>
+#include <cfloat>
 #include "../misc/atomic.h"
 #include "../misc/assert.h"
 #include "../misc/misc.h"
 #include "../misc/lock.h"
-
-
-//+#define USE_ALIGNMENT 1
-//+#include <arch/chip.h>
-//+#include <malloc.h>
+#include "../misc/align.h"
+#include "../misc/pool.h"
+#include "../misc/wait.h"
+#include "../misc/topology.h"
+#include "../misc/stats.h"
 
 namespace SyncTree {
   
@@ -55,84 +57,292 @@ namespace SyncTree {
 		WAIT_ONLY
   };
   
-#define IsLeft(helper, child) (helper->leftChild == child)
-#define PHASE_BITS 15
-#define MAX_PHASE  0x7FFF
-#define HALF_PHASE 0x3FFF
+  /**
+   * Bounded phasers: a SIGNAL_ONLY participant blocks in resume() when it
+   * would get more than `bound` phases ahead of the slowest waiter.
+   * The slowest waiter is either the global phase, i.e., the SIGNAL_WAIT
+   * participants, or the last phase consumed by a WAIT_ONLY participant.
+   * The bound has to stay below HALF_PHASE to keep the phase comparisons safe.
+   */
+#define UNBOUNDED 0
+  
+  /**
+   * Tree-structured release: instead of all participants polling the
+   * phaser's phase, a participant waits on the helper node where its resume
+   * stopped. After being released, it releases the nodes it won on the way
+   * up, top-down, so that every wake flag is only shared within a subtree.
+   * Winners which will not wait for the phase, i.e., SIGNAL_ONLY participants
+   * and the drop actions of the combining thread, mark the node as
+   * RELEASE_DELEGATED instead, and the waiters fall back to the phaser's phase.
+   * WAIT_ONLY participants are not part of the signaling tree and always
+   * poll the phaser's phase.
+   */
+#ifndef SYNC_TREE_RELEASE
+  #define SYNC_TREE_RELEASE false
+#endif
+
+  /**
+   * Topology-aware placement: a new participant is inserted next to the
+   * leaf which shares the narrowest cache domain with the CPU its thread
+   * registered on. Thus, siblings tend to share an L2 or L3 cache, and
+   * participants of another package pair up among themselves, which keeps
+   * most of the resume traffic within a cache domain. Only the shallowest
+   * leaves are considered, to keep the tree balanced.
+   */
+#ifndef SYNC_TREE_TOPOLOGY
+  #define SYNC_TREE_TOPOLOGY false
+#endif
+
+  /**
+   * A thread waiting for its add or drop polls only its own request, and
+   * checks for orphaned requests only every MEMBERSHIP_COMBINE_INTERVAL waits.
+   */
+#ifndef MEMBERSHIP_COMBINE_INTERVAL
+  #define MEMBERSHIP_COMBINE_INTERVAL 64
+#endif
+
+#define MAX_TREE_DEPTH 64
+#define NUM_LOCALITY_LEVELS 3
+  
+#define PHASE_BITS 31
+#define MAX_PHASE  0x7FFFFFFFu
+#define HALF_PHASE 0x3FFFFFFFu
 #define TRUNCATED_PHASE(phase) ((phase) & MAX_PHASE)
+#define RELEASE_DELEGATED (MAX_PHASE + 1)
   
+  /**
+   * Phases wrap around, a is before b, if the distance from b forward to a
+   * is more than half of the phase space, i.e., phases are compared
+   * correctly as long as they are less than HALF_PHASE apart.
+   */
   inline bool LT(const unsigned int a, const unsigned int b) {
-    if (abs(a - b) > HALF_PHASE) {
-      return (b < HALF_PHASE);
-    }
-    return a < b;
+    return TRUNCATED_PHASE(a - b) > HALF_PHASE;
   }
   
   inline bool GT_or_EQ(const unsigned int a, const unsigned int b) {
-    if (abs(a - b) > HALF_PHASE) {
-      return b >= HALF_PHASE;
-    }
-    return a >= b;
+    return TRUNCATED_PHASE(a - b) <= HALF_PHASE;
   }
   
   /**
-   * Should be only set by compare-and-swap
+   * Accumulators allow to combine a value given on resume() by every
+   * participant. The values are combined in the helper nodes while the
+   * resume climbs up the tree, and the participant completing the root
+   * publishes the result, which is returned by next().
+   *
+   * The values of a phase are only combined correctly if no participant
+   * signals the next phase before that phase is completed, i.e., SIGNAL_ONLY
+   * participants are not supported.
+   */
+  enum AccumulatorOperation {
+    ACC_NONE,
+    ACC_SUM,
+    ACC_MIN,
+    ACC_MAX
+  };
+  
+  enum AccumulatorType {
+    ACC_INT64,
+    ACC_DOUBLE
+  };
+  
+  union AccumulatorValue {
+    int64_t asInt64;
+    double  asDouble;
+  };
+  
+  /**
+   * Add and drop set the state by compare-and-swap. A resume only advances
+   * the phase of its side by one, which is done by a fetch-and-add of
+   * phaseIncrement(), except for the wrap-around of the phase, which would
+   * carry into the neighboring field.
    */
   union HelperNodeAtomicState {
-    volatile int value;
+    volatile int64_t value;
     struct bits {
-      bool waitOnlyL:  1;  // this can also mean, that the participant has been dropped, 
-                                    // the consequence is, that the participant will not do any resumes
-      bool waitOnlyR:  1;
-      unsigned int phaseLeft : PHASE_BITS;  // very small, we are using a heuristic to detect overflows
-                                            // phases should not be appart for more then half of MAX_PHASE
-      unsigned int phaseRight: PHASE_BITS;
+      uint64_t waitOnlyL:  1;  // this can also mean, that the participant has been dropped, 
+                               // the consequence is, that the participant will not do any resumes
+      uint64_t waitOnlyR:  1;
+      uint64_t phaseLeft : PHASE_BITS;  // phases should not be appart for more then HALF_PHASE
+      uint64_t phaseRight: PHASE_BITS;
     } bits;
+    
+    static inline int64_t phaseIncrement(const bool isLeft) {
+      HelperNodeAtomicState increment;
+      increment.value = 0;
+      if (isLeft) increment.bits.phaseLeft  = 1;
+      else        increment.bits.phaseRight = 1;
+      return increment.value;
+    }
   };
   
   class HelperNode;
   class Participant;
   
+  /**
+   * The domains of the CPU a participant registered on, from the widest
+   * to the narrowest: package, L3 cache, and L2 cache, -1 if unknown.
+   */
+  class Locality {
+  public:
+    inline Locality() {
+      for (int level = 0; level < NUM_LOCALITY_LEVELS; level++) {
+        domain[level] = -1;
+      }
+    }
+    
+    inline void determine() {
+      const int cpu = topology_current_cpu();
+      domain[0] = topology_package_id(cpu);
+      domain[1] = topology_cache_id(cpu, 3);
+      domain[2] = topology_cache_id(cpu, 2);
+    }
+    
+    /**
+     * @return the number of levels, up to the narrowest domain shared with
+     *         other, levels unknown on this machine are skipped
+     */
+    inline int sharedLevels(const Locality& other) const {
+      int shared = 0;
+      
+      for (int level = 0; level < NUM_LOCALITY_LEVELS; level++) {
+        if (domain[level] == -1) {
+          continue;
+        }
+        if (domain[level] != other.domain[level]) {
+          break;
+        }
+        shared = level + 1;
+      }
+      
+      return shared;
+    }
+    
+  private:
+    int domain[NUM_LOCALITY_LEVELS];
+  };
+  
+  /**
+   * The parent pointer and the side of the node in its parent share a single
+   * word, the lowest bit is set for left children. Thus, a participant
+   * climbing the tree reads both consistently, even while the combining
+   * thread splices a node out of the tree and its child takes its place.
+   */
   class TreeNode {
   public:
-    inline TreeNode() : parent(NULL) {}
+    inline TreeNode() : link(0), numLeaves(1), height(0), minDepth(0) {}
     
-    inline HelperNode* getParent() const       { return parent; }
-    inline void setParent(HelperNode* const p) { parent = p; }
+    inline uintptr_t   getLink()   const { return atomic_load<ORDER_ACQUIRE>(&link); }
+    inline HelperNode* getParent() const { return parentOf(getLink()); }
+    
+    inline void setParent(HelperNode* const p, const bool isLeft) {
+      atomic_store<ORDER_RELEASE>(&link, (uintptr_t)p | (isLeft ? 1 : 0));
+    }
+    
+    static inline HelperNode* parentOf(const uintptr_t link) { return (HelperNode*)(link & ~(uintptr_t)1); }
+    static inline bool        isLeftOf(const uintptr_t link) { return (link & 1) != 0; }
+    
+    inline bool isLeaf() const { return height == 0; }
 
   private:
-    HelperNode* volatile parent;
+    volatile uintptr_t link;
+    
+    // the shape of the subtree, only used by the combining thread
+    int numLeaves;
+    int height;     // longest path to a leaf
+    int minDepth;   // shortest path to a leaf
+    
+    friend class Phaser;
   };
   
-  class HelperNode : public TreeNode {
+  class HelperNode : public TreeNode, public CacheLineAligned {
   public:
-    HelperNode() : TreeNode(), leftChild(NULL) {
+    HelperNode() : TreeNode(), leftChild(NULL), rightChild(NULL), nextRetired(NULL), retiredPhase(0) {
       flags.value = 0;
+      leftValue.asInt64  = 0;
+      rightValue.asInt64 = 0;
+#if BARRIER_STATS
+      contention = 0;
+#endif
     }
 
-    inline void initialize(const unsigned int phase, const TreeNode* const leftChild) {
+    inline void initialize(const unsigned int phase) {
       flags.bits.waitOnlyL  = false;
       flags.bits.waitOnlyR  = false;
       flags.bits.phaseLeft  = phase;
       flags.bits.phaseRight = phase;
-      this->leftChild = leftChild;
+      wakePhase = phase;
+    }
+    
+    /**
+     * Only raises the wake flag, a late release of an earlier phase must not
+     * hide a delegation of a later one.
+     */
+    inline void release(const unsigned int wake) {
+      unsigned int current = atomic_load<ORDER_RELAXED>(&wakePhase);
+      while (LT(current & MAX_PHASE, wake & MAX_PHASE)) {
+        if (atomic_compare_exchange<ORDER_RELEASE>(&wakePhase, current, wake)) {
+          WAIT_POLICY::wake(&wakePhase);
+          return;
+        }
+      }
     }
     
-#ifdef USE_ALIGNMENT
-    void* operator new(size_t size) {
-      return memalign(CHIP_L2_LINE_SIZE(), size);
+    /**
+     * @return the wake flag, which reached the given phase
+     */
+    inline unsigned int awaitRelease(const unsigned int phase) const {
+      WAIT_POLICY waiter(&wakePhase);
+      unsigned int wake = atomic_load<ORDER_ACQUIRE>(&wakePhase);
+      while (LT(wake & MAX_PHASE, phase)) {
+        waiter.wait();
+        wake = atomic_load<ORDER_ACQUIRE>(&wakePhase);
+      }
+      return wake;
     }
+    
+    /**
+     * Counts a failed compare-and-swap on the flags of this node.
+     */
+    inline void countContention() {
+#if BARRIER_STATS
+      atomic_fetch_add<ORDER_RELAXED>(&contention, (uint64_t)1);
 #endif
+      stats_add(STAT_CAS_FAILURES);
+    }
     
-    inline bool isLeftChild(const Participant* const p) {
-      return (const TreeNode*)p == leftChild;
+    inline TreeNode* getChild(const bool isLeft) const { return isLeft ? leftChild : rightChild; }
+    
+    inline void setChild(const bool isLeft, TreeNode* const child) {
+      if (isLeft) leftChild  = child;
+      else        rightChild = child;
     }
     
   private:
     HelperNodeAtomicState flags;  // actually here, version is never initialized, but that is not relevant to fulfill its purpose
     
-    const TreeNode* leftChild;    // this is only necessary to know which phase counter to advance, its not really possible to
-                                  // know which opponent it is from the leave id, at least not if trees are not complerely full
+    // partial accumulator values of the subtrees, written before the phase is signaled
+    AccumulatorValue leftValue;
+    AccumulatorValue rightValue;
+    
+#if BARRIER_STATS
+    // only written after a failed CAS, i.e., while the line is contended anyway
+    volatile uint64_t contention;
+#endif
+    
+    // tree-structured release only: the last released phase,
+    // spun on by the participants which lost at this node
+    CACHE_LINE_PAD(padding0);
+    volatile unsigned int wakePhase;
+    CACHE_LINE_PAD(padding1);
+    
+    // only used by the combining thread, the participants know their side
+    // from their link, so the children can change while they climb
+    TreeNode* leftChild;
+    TreeNode* rightChild;
+    
+    // spliced out nodes wait here, until no participant can read them anymore
+    HelperNode*  nextRetired;
+    unsigned int retiredPhase;
     
     friend class Participant;
     friend class Phaser;
@@ -140,7 +350,7 @@ namespace SyncTree {
   
   class Phaser;
   
-  class Participant : public TreeNode {
+  class Participant : public TreeNode, public CacheLineAligned {
   public:
     inline Participant(Phaser* const phaser);
     inline Participant(Phaser* const phaser, const Mode mode);
@@ -149,24 +359,22 @@ namespace SyncTree {
       drop();
     }
     
-#ifdef USE_ALIGNMENT
-    void* operator new(size_t size) {
-      return memalign(CHIP_L2_LINE_SIZE(), size);
-    }
-#endif
-    
+    /**
+     * Only the first call drops the participant, the destructor calls it
+     * again for participants which were dropped explicitly.
+     */
     inline bool drop();
     
     inline bool resume();
+    inline bool resume(const int64_t value);
+    inline bool resume(const int     value) { return resume((int64_t)value); }
+    inline bool resume(const double  value);
     
-    inline void next() {
-      if (mode != SIGNAL_ONLY) {
-        awaitNextPhase();
-      }
-      
-      // now do the local sense reversal (global is already done on resume/synchronization)
-      resumed = false;
-    }
+    /**
+     * @return the accumulated value of the completed phase,
+     *         only meaningful if the phaser has an accumulator
+     */
+    inline AccumulatorValue next();
     
     inline bool barrier() {
       bool result = resume();
@@ -175,184 +383,757 @@ namespace SyncTree {
     }
     
     inline Mode getMode() const { return mode; }
-    inline void notifyParticipants() const;
+    inline void notifyParticipants(const AccumulatorValue value) const;
     
   private:
     
-    inline void doAllAddActions(const bool reusedNode);
+    /**
+     * The placeholder for the slot a moving participant leaves,
+     * it is not registered and only lives during Phaser::moveInTree().
+     */
+    inline Participant(const Participant* const moving);
+    
+    inline bool resumeWithValue(AccumulatorValue value);
+    
+    inline void doAllAddActions();
     inline bool doAllDropActions();
     
-    //inline void doOptionalYield() const {
-    //	if (DO_YIELD) {
-    //		pthread_yield();
-    //	}
-    //}
-
-    inline void awaitNextPhase() const {
-      //volatile int i;
-      //volatile float a = 0.0;
-      while (LT(*globalPhase, phase)) {
-      //  for (i = 0; i < YIELD; i++) a += i;
-      //	doOptionalYield();
+    inline void awaitGlobalPhase() const {
+      WAIT_POLICY waiter(globalPhase);
+      while (LT(atomic_load<ORDER_ACQUIRE>(globalPhase), phase)) {
+        waiter.wait();
+      }
+    }
+    
+    inline void awaitNextPhase() {
+      if (waitNode) {
+        const unsigned int wake = waitNode->awaitRelease(phase);
+        waitNode = NULL;
+        
+        // a later or delegated release does not tell whether our phase is completed
+        if (wake != phase) {
+          awaitGlobalPhase();
+        }
+      }
+      else {
+        awaitGlobalPhase();
+      }
+      
+      releaseWonNodes(phase);
+    }
+    
+    inline void releaseWonNodes(const unsigned int wake) {
+      // top-down, the larger subtrees are released first
+      while (numWonNodes > 0) {
+        numWonNodes--;
+        wonNodes[numWonNodes]->release(wake);
       }
     }
     
+    inline void awaitBound();
+    
   public:
     const Mode mode;
     bool resumed;
+    bool dropped;
+    volatile bool moveRequested;  // set by the combining thread to rebalance the tree
     unsigned int  phase;   // indicates the phase for this participant
 
     volatile unsigned int* globalPhase; // point to the phasers phase, think it safes only one indirection, but well
     
     Phaser* const phaser;
     
+    // bounded phasers only: WAIT_ONLY participants publish their progress,
+    // SIGNAL_ONLY participants cache the last known slowest phase
+    volatile unsigned int consumedPhase;
+    unsigned int          knownSlowestPhase;
+    Participant*          nextWaiter;
+    
+    // topology-aware placement only
+    Locality     locality;
+    
+    // tree-structured release only: the node the last resume stopped at,
+    // and the nodes it won, which are released by this participant
+    HelperNode*  waitNode;
+    HelperNode*  wonNodes[MAX_TREE_DEPTH];
+    int          numWonNodes;
+    
     friend class Phaser;
-    friend class FreeParticipant;
     friend class TreeNode;
   };
   
-  class FreeParticipant {
-    inline FreeParticipant(const Participant* const participant)
-    : next(NULL), isLeft(participant->getParent()->isLeftChild(participant)), parent(participant->getParent()) {}
+  enum MembershipChange {
+    MEMBER_ADD,
+    MEMBER_DROP,
+    MEMBER_MOVE
+  };
+  
+  /**
+   * A pending add, drop, or move. It is published by the participant's thread and
+   * executed by whichever thread currently combines the pending requests.
+   * Lives on the stack of the publishing thread, thus it must not be
+   * touched anymore after done is set.
+   */
+  class MembershipRequest {
+    inline MembershipRequest(Participant* const participant, const MembershipChange change)
+    : participant(participant), next(NULL), change(change), result(false), done(false) {}
   private:
-    FreeParticipant* next; // next item in the queue
+    Participant* const participant;
+    MembershipRequest* next;
     
-    const bool isLeft;
-    HelperNode* const parent;
+    const MembershipChange change;
+    bool result;
+    volatile bool done;
     
     friend class Phaser;
   };
   
-  class Phaser {
+  class Phaser : public CacheLineAligned {
   public:
-    inline Phaser(const size_t)
-    : leaveCount(0),
-      lastTreeNode(NULL), 
-      firstFree(NULL),
-      lastFree(NULL),
-      phase(0)
+    inline Phaser(const size_t,
+                  const AccumulatorOperation operation = ACC_NONE,
+                  const AccumulatorType      type      = ACC_INT64)
+    : root(NULL),
+      numParticipants(0),
+      numSignalOnly(0),
+      movingParticipant(NULL),
+      firstRetired(NULL),
+      lastRetired(NULL),
+      pendingRequests(NULL),
+      combining(0),
+      phase(0),
+      bound(UNBOUNDED),
+      treeRelease(SYNC_TREE_RELEASE),
+      topologyAware(SYNC_TREE_TOPOLOGY),
+      waiters(NULL),
+      numWaiters(0),
+      slowestConsumedPhase(0),
+      operation(operation),
+      type(type)
     {
-      assert(sizeof(HelperNodeAtomicState) == sizeof(int));
-      lock_init(&insertAndDropLock, NULL);
+      assert(sizeof(HelperNodeAtomicState) == sizeof(int64_t));
+      lock_init(&waitersLock, 0);
+      
+      results[0] = identity();
+      results[1] = identity();
     }
     
     inline void add(Participant* const participant) {
+      // SIGNAL_ONLY participants would mix the values of two phases
+      assert(!(hasAccumulator() && participant->mode == SIGNAL_ONLY));
+      
       // first make sure the participant is initalized correctly
       participant->globalPhase = &phase;
       
-      lock_acquire(&insertAndDropLock);
+      MembershipRequest request(participant, MEMBER_ADD);
+      executeMembershipRequest(&request);
       
-      if (firstFree) {
-        reuseFree(participant);
-      }
-      else {
-        insertNewIntoTree(participant);
+      if (bound != UNBOUNDED && participant->mode == WAIT_ONLY) {
+        addWaiter(participant);
       }
-      
-      lock_release(&insertAndDropLock);
     }    
     
     inline void finalize_initialization() const {}
     
-  private:
-    inline void reuseFree(Participant* const participant) {     
-      FreeParticipant* const freeP = firstFree;
+    /**
+     * Limit how far SIGNAL_ONLY participants may run ahead of the slowest
+     * waiter. Has to be set before the first participant registers.
+     */
+    inline void setBound(const unsigned int bound) {
+      assert(bound < HALF_PHASE);
+      this->bound = bound;
+    }
+    
+    inline unsigned int getBound() const { return bound; }
+    
+    /**
+     * Release the participants through the helper nodes instead of the
+     * phaser's phase. Has to be set before the first participant registers.
+     */
+    inline void setTreeRelease(const bool treeRelease) {
+      this->treeRelease = treeRelease;
+    }
+    
+    /**
+     * Place participants by the cache domains of the CPU they register on.
+     * Has to be set before the first participant registers.
+     */
+    inline void setTopologyAware(const bool topologyAware) {
+      this->topologyAware = topologyAware;
+    }
+    
+    /**
+     * Lock-free, reads the global phase and the cached slowest waiter.
+     * A stale cache is never ahead of the waiters, it only lets the
+     * producer wait for the next wake.
+     * @return the earliest phase, which is not yet consumed by all waiters
+     */
+    inline unsigned int slowestWaiterPhase() const {
+      unsigned int slowest = atomic_load<ORDER_ACQUIRE>(&phase);
       
-      firstFree = freeP->next;
-      if (firstFree == NULL) {
-        lastFree = NULL;
+      if (atomic_load<ORDER_ACQUIRE>(&numWaiters) > 0) {
+        const unsigned int consumed = atomic_load<ORDER_ACQUIRE>(&slowestConsumedPhase);
+        if (LT(consumed, slowest)) {
+          slowest = consumed;
+        }
       }
       
-      if (lastTreeNode == NULL) {
-        // that should be fine, insertNode is only zero, if we dropped the node where insertNode was pointing at
-        //participant->insertLockIfInsertNode = &insertAndDropLock;
-        lastTreeNode = participant;
+      return slowest;
+    }
+    
+    /**
+     * Called by a waiter, which consumed the phase after `consumed`.
+     * Only if it was the slowest one, the cache has to be recomputed.
+     */
+    inline void waiterConsumed(const unsigned int consumed) {
+      if (consumed == atomic_load<ORDER_ACQUIRE>(&slowestConsumedPhase)) {
+        lock_acquire(&waitersLock);
+        updateSlowestConsumedPhase();
+        lock_release(&waitersLock);
+        
+        WAIT_POLICY::wake(&bound);
       }
+    }
+    
+    /**
+     * Copies the number of failed CAS of every helper node, in pre-order.
+     * Only consistent while the membership of the phaser does not change,
+     * and all counts are 0 without BARRIER_STATS.
+     * @return the number of helper nodes, which can be larger than maxNodes
+     */
+    inline size_t snapshotNodeContention(uint64_t* const counts, const size_t maxNodes) const {
+      return collectNodeContention(root, counts, maxNodes, 0);
+    }
+    
+    inline bool hasAccumulator() const { return operation != ACC_NONE; }
+    
+    /**
+     * @return the neutral element of the accumulator operation
+     */
+    inline AccumulatorValue identity() const {
+      AccumulatorValue result;
       
-      participant->setParent(freeP->parent);
-      //participant->setLeaveId(freeP->leaveId);
+      if (type == ACC_INT64) {
+        switch (operation) {
+          case ACC_MIN: result.asInt64 = INT64_MAX; break;
+          case ACC_MAX: result.asInt64 = INT64_MIN; break;
+          default:      result.asInt64 = 0;         break;
+        }
+      }
+      else {
+        switch (operation) {
+          case ACC_MIN: result.asDouble =  DBL_MAX; break;
+          case ACC_MAX: result.asDouble = -DBL_MAX; break;
+          default:      result.asDouble = 0.0;      break;
+        }
+      }
       
-      participant->doAllAddActions(true);
+      return result;
     }
     
-    inline bool drop(Participant* const participant) {
-      bool result = false;
+    inline AccumulatorValue combine(const AccumulatorValue a, const AccumulatorValue b) const {
+      AccumulatorValue result;
       
-      lock_acquire(&insertAndDropLock);
-      HelperNode* const parent = participant->getParent();
+      if (type == ACC_INT64) {
+        switch (operation) {
+          case ACC_MIN: result.asInt64 = (a.asInt64 < b.asInt64) ? a.asInt64 : b.asInt64; break;
+          case ACC_MAX: result.asInt64 = (a.asInt64 > b.asInt64) ? a.asInt64 : b.asInt64; break;
+          default:      result.asInt64 = a.asInt64 + b.asInt64;                           break;
+        }
+      }
+      else {
+        switch (operation) {
+          case ACC_MIN: result.asDouble = (a.asDouble < b.asDouble) ? a.asDouble : b.asDouble; break;
+          case ACC_MAX: result.asDouble = (a.asDouble > b.asDouble) ? a.asDouble : b.asDouble; break;
+          default:      result.asDouble = a.asDouble + b.asDouble;                              break;
+        }
+      }
       
-      if (parent) {
-        result = participant->doAllDropActions();
-        
-        if (participant == lastTreeNode) {
-          // assert(lastTreeNode->insertLockIfInsertNode);
-          // make sure we do not have any dangling pointers
-          lastTreeNode = NULL;
+      return result;
+    }
+    
+  private:
+    /**
+     * Add and drop change the structure and the WAIT_ONLY flags of the tree,
+     * and those changes are not safe to race with each other.
+     * Instead of serializing all threads on a lock, every thread publishes its
+     * request with a CAS and spins on its own request. The thread that wins
+     * the combining flag takes all pending requests at once and applies them,
+     * so during a spawn storm the tree is modified by a single thread, which
+     * keeps the tree's cache lines local and the contention on a single word.
+     * After releasing the flag, the combiner checks for requests published
+     * meanwhile, and the publisher checks for a combiner right after its CAS,
+     * so at least one of them sees the other and no request is orphaned.
+     *
+     * This is not lock-free: while the combiner is descheduled, all pending
+     * requests wait for it. Concurrent inserts can not be made lock-free here,
+     * since the add actions of two new participants climb the same ancestors,
+     * and each of them waits for the phase it expects on the side it came
+     * from, which the other one may already have reset. Splicing on drop
+     * and moves rewire the same links, too.
+     */
+    inline void executeMembershipRequest(MembershipRequest* const request) {
+      MembershipRequest* head = atomic_load<ORDER_RELAXED>(&pendingRequests);
+      do {
+        request->next = head;
+      } while (!atomic_compare_exchange<ORDER_SEQ_CST>(&pendingRequests, head, request));
+      
+      WAIT_POLICY waiter(&request->done);
+      unsigned int waits = MEMBERSHIP_COMBINE_INTERVAL;
+      while (!atomic_load<ORDER_ACQUIRE>(&request->done)) {
+        if (waits >= MEMBERSHIP_COMBINE_INTERVAL) {
+          waits = 0;
+          combinePendingRequests();
+        }
+        else {
+          waits++;
+          waiter.wait();
+        }
+      }
+    }
+    
+    /**
+     * Combines until no request is pending, or another thread holds the
+     * combining flag, which then checks for pending requests after it
+     * released the flag.
+     */
+    inline void combinePendingRequests() {
+      while (atomic_load<ORDER_SEQ_CST>(&pendingRequests) != NULL) {
+        int idle = 0;
+        if (atomic_load<ORDER_SEQ_CST>(&combining) != 0
+            || !atomic_compare_exchange<ORDER_ACQUIRE>(&combining, idle, 1)) {
+          return;
         }
         
-        // now create the new FreeParticipant and enqueue it
-        FreeParticipant* const freeP = new FreeParticipant(participant);
+        combineMembershipRequests();
+        atomic_store<ORDER_SEQ_CST>(&combining, 0);
+      }
+    }
+    
+    inline void combineMembershipRequests() {
+      MembershipRequest* batch = atomic_exchange<ORDER_ACQUIRE>(&pendingRequests, (MembershipRequest*)NULL);
+      
+      // requests were pushed LIFO, apply them in the order they arrived
+      MembershipRequest* ordered = NULL;
+      while (batch) {
+        MembershipRequest* const next = batch->next;
+        batch->next = ordered;
+        ordered = batch;
+        batch = next;
+      }
+      
+      while (ordered) {
+        MembershipRequest* const next = ordered->next;
+        Participant* const participant = ordered->participant;
         
-        if (lastFree) {
-          lastFree->next = freeP;
+        switch (ordered->change) {
+          case MEMBER_ADD:
+            numParticipants++;
+            if (participant->mode == SIGNAL_ONLY) {
+              numSignalOnly++;
+            }
+            
+            insertIntoTree(participant);
+            break;
+            
+          case MEMBER_DROP:
+            if (participant == movingParticipant) {
+              movingParticipant = NULL;
+            }
+            
+            ordered->result = dropFromTree(participant);
+            
+            numParticipants--;
+            if (participant->mode == SIGNAL_ONLY) {
+              numSignalOnly--;
+            }
+            
+            if (numParticipants == 0) {
+              reclaimTree();
+            }
+            break;
+            
+          case MEMBER_MOVE:
+            moveInTree(participant);
+            break;
         }
         
-        lastFree = freeP;
-        
-        // this is the case if the queue is empty
-        if (!firstFree) {
-          assert(freeP->next == NULL);
-          firstFree = freeP;
+        // publishes everything the combiner did on the requester's behalf,
+        // wake only uses the address, the request itself may be gone already
+        atomic_store<ORDER_RELEASE>(&ordered->done, true);
+        WAIT_POLICY::wake(&ordered->done);
+        ordered = next;
+      }
+      
+      if (root) {
+        reuseRetiredNodes();
+        requestMove();
+      }
+    }
+    
+    inline void addWaiter(Participant* const participant) {
+      participant->consumedPhase = participant->phase;
+      
+      lock_acquire(&waitersLock);
+      participant->nextWaiter = waiters;
+      waiters = participant;
+      updateSlowestConsumedPhase();
+      atomic_store<ORDER_RELEASE>(&numWaiters, numWaiters + 1);
+      lock_release(&waitersLock);
+    }
+    
+    inline void removeWaiter(Participant* const participant) {
+      lock_acquire(&waitersLock);
+      Participant** current = &waiters;
+      while (*current) {
+        if (*current == participant) {
+          *current = participant->nextWaiter;
+          updateSlowestConsumedPhase();
+          atomic_store<ORDER_RELEASE>(&numWaiters, numWaiters - 1);
+          break;
         }
+        current = &(*current)->nextWaiter;
       }
-      else {
-        // it was the only participant, lets just set all relevant pointers to NULL
-        leaveCount = 0;
-        lastTreeNode = NULL;
-        assert(firstFree == NULL);
+      lock_release(&waitersLock);
+      
+      // the dropped waiter might have been the slowest one
+      WAIT_POLICY::wake(&bound);
+    }
+    
+    /**
+     * Has to hold the waitersLock. Without waiters, the cache is ignored.
+     */
+    inline void updateSlowestConsumedPhase() {
+      Participant* waiter = waiters;
+      if (!waiter) {
+        return;
       }
       
-      lock_release(&insertAndDropLock);
+      unsigned int slowest = waiter->consumedPhase;
+      for (waiter = waiter->nextWaiter; waiter; waiter = waiter->nextWaiter) {
+        const unsigned int consumed = waiter->consumedPhase;
+        if (LT(consumed, slowest)) {
+          slowest = consumed;
+        }
+      }
+      
+      atomic_store<ORDER_RELEASE>(&slowestConsumedPhase, slowest);
+    }
+    
+    /**
+     * After the last participant dropped, no thread is going to touch the
+     * helper nodes anymore: drops are executed by the combiner, and a
+     * participant waiting on a node or resuming through it is still registered.
+     * Thus, all nodes are reclaimed at once, including the retired ones.
+     */
+    inline void reclaimTree() {
+      helperNodes.releaseAll();
+      
+      root              = NULL;
+      firstRetired      = NULL;
+      lastRetired       = NULL;
+      movingParticipant = NULL;
+    }
+    
+    inline bool drop(Participant* const participant) {
+      if (bound != UNBOUNDED && participant->mode == WAIT_ONLY) {
+        removeWaiter(participant);
+      }
+      
+      MembershipRequest request(participant, MEMBER_DROP);
+      executeMembershipRequest(&request);
+      
+      return request.result;
+    }
+    
+    /**
+     * Moves the participant to a shallower leaf, only called by the
+     * participant itself, when it was asked to do so by the combiner.
+     */
+    inline void move(Participant* const participant) {
+      MembershipRequest request(participant, MEMBER_MOVE);
+      executeMembershipRequest(&request);
+    }
+    
+    inline bool dropFromTree(Participant* const participant) {
+      bool result = false;
+      
+      // the only participant does not have to signal anybody
+      if (participant->getParent()) {
+        result = participant->doAllDropActions();
+      }
       
+      removeFromTree(participant);
       return result;
     }
     
-    inline void insertNewIntoTree(Participant* const participant) {
-      // just checking, that we have not missed any free nodes
-      assert(firstFree == NULL);
-      assert(lastFree  == NULL);
+    /**
+     * Splices the dropped leaf and its parent out of the tree, and the
+     * sibling takes the parent's place. Thus, the tree never contains dropped
+     * leaves, and its height follows the number of registered participants.
+     *
+     * The drop actions already marked the leaf's side WAIT_ONLY, so
+     * participants which climb from the sibling's subtree, and still read
+     * the old link, win at the parent without waiting and arrive at the
+     * same side of the grandparent, as the ones reading the new link.
+     * Therefore, the parent stays untouched until it is reused, cf. retire().
+     */
+    inline void removeFromTree(TreeNode* const leaf) {
+      HelperNode* const parent = leaf->getParent();
+      
+      if (parent == NULL) {
+        root = NULL;
+        return;
+      }
+      
+      TreeNode* const sibling = parent->getChild(not TreeNode::isLeftOf(leaf->getLink()));
+      
+      const uintptr_t   parentLink  = parent->getLink();
+      HelperNode* const grandparent = TreeNode::parentOf(parentLink);
+      const bool        parentIsLeft = TreeNode::isLeftOf(parentLink);
+      
+      sibling->setParent(grandparent, parentIsLeft);
+      
+      if (grandparent) {
+        grandparent->setChild(parentIsLeft, sibling);
+      }
+      else {
+        root = sibling;
+      }
+      
+      retire(parent);
+      updateShape(grandparent);
+    }
+    
+    /**
+     * Participants, which loaded a link to the node before it was spliced
+     * out, are at most one phase ahead of the phaser, or `bound` phases for
+     * SIGNAL_ONLY participants. They are done with the node, when they
+     * signal the phase after that one, which is the case as soon as the
+     * phaser completed it. The phase has to be read after the splice.
+     */
+    inline void retire(HelperNode* const helper) {
+      memory_fence();
+      helper->retiredPhase = atomic_load<ORDER_ACQUIRE>(&phase);
+      helper->nextRetired  = NULL;
       
-      TreeNode* const insertNode = getNextInsertNode(lastTreeNode);
+      if (lastRetired) {
+        lastRetired->nextRetired = helper;
+      }
+      else {
+        firstRetired = helper;
+      }
+      lastRetired = helper;
+    }
+    
+    /**
+     * Without a bound, SIGNAL_ONLY participants can be arbitrarily far
+     * ahead, thus, retired nodes are only reused while none is registered.
+     */
+    inline void reuseRetiredNodes() {
+      if (numSignalOnly > 0 && bound == UNBOUNDED) {
+        return;
+      }
+      
+      const unsigned int grace   = (numSignalOnly > 0) ? bound + 2 : 2;
+      const unsigned int current = atomic_load<ORDER_ACQUIRE>(&phase);
       
-      // increase leave count, this determines next insert position
-      leaveCount++;
-      //participant->setLeaveId(leaveCount);
+      while (firstRetired && TRUNCATED_PHASE(current - firstRetired->retiredPhase) >= grace) {
+        HelperNode* const helper = firstRetired;
+        firstRetired = helper->nextRetired;
+        helperNodes.release(helper);
+      }
       
+      if (firstRetired == NULL) {
+        lastRetired = NULL;
+      }
+    }
+    
+    /**
+     * Recomputes the shape of the subtrees from the given node up to the root.
+     */
+    inline void updateShape(HelperNode* node) {
+      while (node) {
+        const TreeNode* const left  = node->leftChild;
+        const TreeNode* const right = node->rightChild;
+        
+        node->numLeaves = left->numLeaves + right->numLeaves;
+        node->height    = 1 + ((left->height   > right->height)   ? left->height   : right->height);
+        node->minDepth  = 1 + ((left->minDepth < right->minDepth) ? left->minDepth : right->minDepth);
+        
+        node = node->getParent();
+      }
+    }
+    
+    inline bool isBalanced() const {
+      return root == NULL || root->height <= root->minDepth + 1;
+    }
+    
+    /**
+     * Splicing only removes nodes, but the remaining leaves can end up at
+     * very different depths. Then, one of the deepest leaves is asked to move
+     * to the shallowest one, which it does between two phases, cf.
+     * Participant::next(). Every move reduces the sum of all leaf depths,
+     * thus, the tree converges to a height of at most log2(n) + 1.
+     * Only SIGNAL_WAIT participants are moved, since only for them the phase
+     * they are in is known, when they are between two phases.
+     */
+    inline void requestMove() {
+      if (movingParticipant || isBalanced()) {
+        return;
+      }
+      
+      TreeNode* deepest = root;
+      while (not deepest->isLeaf()) {
+        const HelperNode* const helper = static_cast<const HelperNode*>(deepest);
+        deepest = (helper->leftChild->height >= helper->rightChild->height)
+                      ? helper->leftChild : helper->rightChild;
+      }
+      
+      // the sibling of a deepest leaf is a leaf as well
+      const uintptr_t link = deepest->getLink();
+      TreeNode* const sibling = TreeNode::parentOf(link)->getChild(not TreeNode::isLeftOf(link));
+      
+      Participant* candidate = static_cast<Participant*>(deepest);
+      if (candidate->mode != SIGNAL_WAIT) {
+        candidate = static_cast<Participant*>(sibling);
+      }
+      
+      if (candidate->mode == SIGNAL_WAIT) {
+        movingParticipant = candidate;
+        atomic_store<ORDER_RELAXED>(&candidate->moveRequested, true);
+      }
+    }
+    
+    /**
+     * Moves a participant, which is between two phases, to the shallowest
+     * leaf. A placeholder takes over its old slot, then the participant is
+     * added like a new one, and finally the placeholder is dropped, which
+     * signals the next phase for the old slot. Meanwhile, the participant's
+     * new slot holds the phase back, so that it can not complete early.
+     */
+    inline void moveInTree(Participant* const participant) {
+      movingParticipant = NULL;
+      
+      int depth = 0;
+      for (HelperNode* node = participant->getParent(); node; node = node->getParent()) {
+        depth++;
+      }
+      
+      // the tree might have changed since the move was requested
+      if (depth <= root->minDepth + 1) {
+        return;
+      }
+      
+      Participant placeholder(participant);
+      
+      const uintptr_t   link   = participant->getLink();
+      HelperNode* const parent = TreeNode::parentOf(link);
+      placeholder.setParent(parent, TreeNode::isLeftOf(link));
+      parent->setChild(TreeNode::isLeftOf(link), &placeholder);
+      
+      insertIntoTree(participant);
+      
+      dropFromTree(&placeholder);
+      placeholder.dropped = true;
+    }
+    
+    /**
+     * @return the leftmost of the shallowest leaves, or with topology-aware
+     *         placement, the one closest to the participant
+     */
+    inline TreeNode* findInsertNode(const Participant* const participant) const {
+      if (topologyAware) {
+        TreeNode* closest = NULL;
+        int sharedLevels  = -1;
+        findClosestLeaf(root, 0, participant->locality, closest, sharedLevels);
+        return closest;
+      }
+      
+      TreeNode* insertNode = root;
+      while (not insertNode->isLeaf()) {
+        const HelperNode* const node = static_cast<const HelperNode*>(insertNode);
+        insertNode = (node->leftChild->minDepth <= node->rightChild->minDepth)
+                         ? node->leftChild : node->rightChild;
+      }
+      return insertNode;
+    }
+    
+    /**
+     * Visits the shallowest leaves below node, from left to right, and keeps
+     * the first one sharing the most levels with the given locality.
+     */
+    inline void findClosestLeaf(TreeNode* const node, const int depth, const Locality& locality,
+                                TreeNode*& closest, int& sharedLevels) const {
+      if (depth + node->minDepth > root->minDepth || sharedLevels == NUM_LOCALITY_LEVELS) {
+        return;
+      }
+      
+      if (node->isLeaf()) {
+        const int shared = static_cast<const Participant*>(node)->locality.sharedLevels(locality);
+        if (shared > sharedLevels) {
+          closest      = node;
+          sharedLevels = shared;
+        }
+        return;
+      }
+      
+      const HelperNode* const helper = static_cast<const HelperNode*>(node);
+      findClosestLeaf(helper->leftChild,  depth + 1, locality, closest, sharedLevels);
+      findClosestLeaf(helper->rightChild, depth + 1, locality, closest, sharedLevels);
+    }
+    
+    static size_t collectNodeContention(const TreeNode* const node, uint64_t* const counts,
+                                        const size_t maxNodes, size_t numNodes) {
+      if (node == NULL || node->isLeaf()) {
+        return numNodes;
+      }
+      
+      const HelperNode* const helper = static_cast<const HelperNode*>(node);
+      if (numNodes < maxNodes) {
+#if BARRIER_STATS
+        counts[numNodes] = helper->contention;
+#else
+        counts[numNodes] = 0;
+#endif
+      }
+      numNodes++;
+      
+      numNodes = collectNodeContention(helper->leftChild, counts, maxNodes, numNodes);
+      return     collectNodeContention(helper->rightChild, counts, maxNodes, numNodes);
+    }
+    
+    /**
+     * The new participant gets a helper node together with the shallowest
+     * leaf, which keeps the tree balanced, also after splicing.
+     */
+    inline void insertIntoTree(Participant* const participant) {
       // if there is nothing yet, insert first node
-      if (insertNode == NULL) {
-        participant->setParent(NULL);
-        lastTreeNode = participant;
+      if (root == NULL) {
+        participant->setParent(NULL, false);
+        root = participant;
         return;
       }
       
+      TreeNode* const insertNode = findInsertNode(participant);
+      
       // the general case, when there is already some tree
       const unsigned int phase = participant->phase;
       
-      HelperNode* const helper = new HelperNode();
-      HelperNode* const insertParent = insertNode->getParent();
-      helper->setParent(insertParent);
+      HelperNode* const helper = ::new (helperNodes.allocate()) HelperNode();
+      const uintptr_t   insertLink   = insertNode->getLink();
+      HelperNode* const insertParent = TreeNode::parentOf(insertLink);
+      const bool        insertIsLeft = TreeNode::isLeftOf(insertLink);
+      helper->setParent(insertParent, insertIsLeft);
       
-      helper->initialize(phase, insertNode);
+      helper->initialize(phase);
+      helper->leftChild  = insertNode;
+      helper->rightChild = participant;
       
-      // make sure that the waitOnly is set, getting this info is a bit
-      // difficulte here, insertNode is the last leave, or it is a helper
+      // make sure that the waitOnly is set, the insertNode is always a leaf,
       // this does not need to be atomic since WAIT_ONLY flags only change
-      // protected by the insert lock we already acquired
-      if (   (insertNode == lastTreeNode && (lastTreeNode->getMode() == WAIT_ONLY))
-          || (   ((HelperNode*)insertNode)->flags.bits.waitOnlyL
-              && ((HelperNode*)insertNode)->flags.bits.waitOnlyR))
-      {
-        assert(not helper->flags.bits.waitOnlyL); // just make sure it was correctly initialized...
+      // by add and drop, which are all executed by the combining thread
+      if (static_cast<Participant*>(insertNode)->getMode() == WAIT_ONLY) {
         helper->flags.bits.waitOnlyL = true;
       }
       
@@ -364,7 +1145,14 @@ namespace SyncTree {
       memory_fence();
       
       // Now modify the tree
-      insertNode->setParent(helper);
+      insertNode->setParent(helper, true);
+      
+      if (insertParent) {
+        insertParent->setChild(insertIsLeft, helper);
+      }
+      else {
+        root = helper;
+      }
       
       // make sure this change is propergated properly
       memory_fence();
@@ -376,20 +1164,30 @@ namespace SyncTree {
       unsigned int numSignals = 0;
       if (insertParent) {
         bool cas_successful = false;
-        HelperNodeAtomicState currentValue = insertParent->flags;
+        HelperNodeAtomicState currentValue;
+        currentValue.value = atomic_load<ORDER_RELAXED>(&insertParent->flags.value);
         do {
           HelperNodeAtomicState newValue = currentValue;
 
-          // remember the signals we have to set on the helper
-          numSignals = currentValue.bits.phaseRight - phase;
-          assert(numSignals >= 0);  // well, it should be at least in the current phase, otherwise something is going entierly wrong with the whole tree
-          
-          newValue.bits.phaseRight = phase;
-          newValue.bits.waitOnlyR  = newValue.bits.waitOnlyR && (participant->mode == WAIT_ONLY);
+          // remember the signals we have to set on the helper,
+          // well, it should be at least in the current phase, otherwise something is going entierly wrong with the whole tree
+          if (insertIsLeft) {
+            numSignals = TRUNCATED_PHASE(currentValue.bits.phaseLeft - phase);
+            
+            newValue.bits.phaseLeft = phase;
+            newValue.bits.waitOnlyL = newValue.bits.waitOnlyL && (participant->mode == WAIT_ONLY);
+          }
+          else {
+            numSignals = TRUNCATED_PHASE(currentValue.bits.phaseRight - phase);
+            
+            newValue.bits.phaseRight = phase;
+            newValue.bits.waitOnlyR  = newValue.bits.waitOnlyR && (participant->mode == WAIT_ONLY);
+          }
+          assert(numSignals < HALF_PHASE);
           
           // now the new flags are prepared, and we can try to install them
           HelperNodeAtomicState oldFlags;
-          oldFlags.value = atomic_compare_and_swap((int*)&insertParent->flags.value, currentValue.value, newValue.value);
+          oldFlags.value = atomic_compare_and_swap((int64_t*)&insertParent->flags.value, currentValue.value, newValue.value);
           
           if (oldFlags.value == currentValue.value) {
             // CAS was sucessful, and we can exit the loop
@@ -398,14 +1196,19 @@ namespace SyncTree {
           else {
             // lets try again, but use reuse the read value for next round
             currentValue = oldFlags;
+            insertParent->countContention();
           }
         } while (not cas_successful);
       }
       
       // Second make sure that the signals are set on the helper if necessary
       if (numSignals != 0) {
+        // the signal came with the partial value of the insertNode's subtree
+        helper->leftValue = insertIsLeft ? insertParent->leftValue : insertParent->rightValue;
+        
         bool keep_trying = true;
-        HelperNodeAtomicState currentValue = helper->flags;
+        HelperNodeAtomicState currentValue;
+        currentValue.value = atomic_load<ORDER_RELAXED>(&helper->flags.value);
         do {
           if (currentValue.bits.phaseLeft != phase) {
             break;
@@ -418,13 +1221,15 @@ namespace SyncTree {
           
           // now the new flags are prepared, and we can try to install them
           HelperNodeAtomicState oldFlags;
-          oldFlags.value = atomic_compare_and_swap((int*)&helper->flags.value, currentValue.value, newValue.value);
+          oldFlags.value = atomic_compare_and_swap((int64_t*)&helper->flags.value, currentValue.value, newValue.value);
           
           if (oldFlags.value == currentValue.value) {
             // CAS was sucessful, and we can exit the loop
             keep_trying = false;
           }
           else {
+            helper->countContention();
+            
             if (oldFlags.bits.phaseLeft == phase) {
               keep_trying = true;
             }
@@ -438,42 +1243,51 @@ namespace SyncTree {
       
       
       // the participant is the least important item, and can be handled now.
-      // using stack-allocation, the thread exacuting this code here,
-      // should allways be the participant anyway
-      participant->setParent(helper);
-      
-      participant->doAllAddActions(false);
-      
-      lastTreeNode = participant;
-    }
-    
-    inline TreeNode* getNextInsertNode(Participant* const lastNode) const {
-      if (!lastNode) {
-        return NULL;
-      }
-      
-      TreeNode* result = lastNode;
-      
-      int tmp = leaveCount;
+      // this may run on the combiner's thread, the participant's own thread
+      // waits on its request until all add actions are done
+      participant->setParent(helper, false);
+      updateShape(helper);
       
-      while ((tmp & 1) == 0) {  // while(tmp % 2 == 0)
-      	//printf("getNextInsertNode: tmp=%d, result=%p\n", tmp, result);
-      	assert(result != NULL);
-        result = result->getParent();
-        tmp >>= 1;            // tmp /= 2;
-      }
-      
-      return result;
+      participant->doAllAddActions();
     }
+
   public:
-    volatile int              leaveCount;
-    Participant*     volatile lastTreeNode;
-    FreeParticipant* volatile firstFree;
-    FreeParticipant* volatile lastFree;
-    lock_t insertAndDropLock;
+    // the tree, only changed by the combining thread
+    TreeNode*    root;
+    int          numParticipants; // registered and not dropped
+    int          numSignalOnly;
+    Participant* movingParticipant;
+    HelperNode*  firstRetired;
+    HelperNode*  lastRetired;
+    
+    // add and drop requests, which are not yet executed
+    MembershipRequest* volatile pendingRequests;
+    volatile int                combining;
+    
+    // the tree's nodes, only allocated and released by the combiner
+    NodePool<HelperNode> helperNodes;
+    CACHE_LINE_PAD(padding0);
     
     // global phase, used as waitFlag
     volatile unsigned int  phase;
+    CACHE_LINE_PAD(padding1);
+    
+    // bounded phasers only
+    unsigned int  bound;
+    bool          treeRelease;
+    bool          topologyAware;
+    Participant*  waiters;
+    lock_t        waitersLock;
+    // maintained under the waitersLock, read without it by awaitBound()
+    volatile unsigned int numWaiters;
+    volatile unsigned int slowestConsumedPhase;
+    CACHE_LINE_PAD(padding2);
+    
+    const AccumulatorOperation operation;
+    const AccumulatorType      type;
+    
+    // accumulated value of the last two phases, indexed by the phase's parity
+    AccumulatorValue results[2];
     
     friend class Participant;
   };
@@ -481,12 +1295,33 @@ namespace SyncTree {
   /**
    * Propagate the resume up the tree.
    * Resume is always called on the leave node i.e. participant node first.
-   *
-   * REM we need to acquire the insert/drop lock if we are the insert node.
-   *     The insert node with the look does not have to be the participant node,
-   *     i.e. it might be one of the helper nodes up the tree
    */
   inline bool Participant::resume() {
+    AccumulatorValue v;
+    v.asInt64 = 0;
+    
+    if (phaser->hasAccumulator()) {
+      v = phaser->identity();
+    }
+    
+    return resumeWithValue(v);
+  }
+  
+  inline bool Participant::resume(const int64_t value) {
+    AccumulatorValue v;
+    if (phaser->type == ACC_INT64) v.asInt64  = value;
+    else                           v.asDouble = (double)value;
+    return resumeWithValue(v);
+  }
+  
+  inline bool Participant::resume(const double value) {
+    AccumulatorValue v;
+    if (phaser->type == ACC_INT64) v.asInt64  = (int64_t)value;
+    else                           v.asDouble = value;
+    return resumeWithValue(v);
+  }
+  
+  inline bool Participant::resumeWithValue(AccumulatorValue value) {
     // do nothing if we already resumed, or don't signal at all
     if (resumed || mode == WAIT_ONLY) {
       return false;
@@ -496,65 +1331,104 @@ namespace SyncTree {
     if (mode != SIGNAL_ONLY) {
       resumed = true;
     }
+    else if (phaser->bound != UNBOUNDED) {
+      awaitBound();
+    }
     
     // the hard part...
     phase = TRUNCATED_PHASE(phase + 1);
 
-    HelperNode* node   = getParent();
-    const TreeNode* lastNode = this;
+    uintptr_t   link = getLink();
+    HelperNode* node = TreeNode::parentOf(link);
         
+    const bool accumulate = phaser->hasAccumulator();
+    
     bool propagateResumeFurther = true;
     HelperNodeAtomicState currentFlags;
     
     while (node && propagateResumeFurther) {
-      const bool isLeft = IsLeft(node, lastNode);
-      bool compareAndSwap_failed = true;
-      currentFlags = node->flags;
+      const bool isLeft = TreeNode::isLeftOf(link);
       
-      // propagateResumeFurther does not need to be CASSafe, we do not read it
+      // the value has to be there before the phase is signaled,
+      // since the opponent continues with it if we lose
+      if (accumulate) {
+        if (isLeft) node->leftValue  = value;
+        else        node->rightValue = value;
+      }
       
-      do {
-        HelperNodeAtomicState newFlags = currentFlags;
-
-        if (isLeft) {
-          newFlags.bits.phaseLeft  = phase;
-          propagateResumeFurther = 
-                  currentFlags.bits.waitOnlyR     // if they are wait only, we will lose 
-                  // if the opponent already set the phase to ours, or bigger, we also have lost
-                  || GT_or_EQ(currentFlags.bits.phaseRight, phase);
+      // our side is always one phase behind, thus a single fetch-and-add
+      // advances it, and returns the opponent's state we raced with,
+      // release publishes our value, acquire makes the opponent's visible
+      if (phase != 0) {
+        currentFlags.value = atomic_fetch_add<ORDER_ACQ_REL>(
+                               &node->flags.value, HelperNodeAtomicState::phaseIncrement(isLeft));
+        assert(TRUNCATED_PHASE((isLeft ? currentFlags.bits.phaseLeft : currentFlags.bits.phaseRight) + 1) == phase);
+      }
+      else {
+        // the phase wraps around, set it explicitly
+        currentFlags.value = atomic_load<ORDER_RELAXED>(&node->flags.value);
+        bool compareAndSwap_failed = true;
+        do {
+          HelperNodeAtomicState newFlags = currentFlags;
+          if (isLeft) newFlags.bits.phaseLeft  = phase;
+          else        newFlags.bits.phaseRight = phase;
+          
+          // on failure, reuse the read value for next round
+          int64_t expected = currentFlags.value;
+          compareAndSwap_failed = not atomic_compare_exchange<ORDER_ACQ_REL>(
+                                    &node->flags.value, expected, newFlags.value);
+          currentFlags.value = expected;
+          
+          if (compareAndSwap_failed) {
+            node->countContention();
+          }
         }
-        else {
-          newFlags.bits.phaseRight = phase;
-          propagateResumeFurther = 
-                  currentFlags.bits.waitOnlyL    // if they are wait only, we will lose 
-                  // if the opponent already set the phase to ours, or bigger, we also have lost
-                  || GT_or_EQ(currentFlags.bits.phaseLeft,  phase);
+        while (compareAndSwap_failed);
+      }
+      
+      // if they are wait only, or already set the phase to ours, or bigger, we won
+      if (isLeft) {
+        propagateResumeFurther =    currentFlags.bits.waitOnlyR
+                                 || GT_or_EQ(currentFlags.bits.phaseRight, phase);
+      }
+      else {
+        propagateResumeFurther =    currentFlags.bits.waitOnlyL
+                                 || GT_or_EQ(currentFlags.bits.phaseLeft,  phase);
+      }
+      
+      if (phaser->treeRelease) {
+        if (mode == SIGNAL_ONLY) {
+          // we are not going to wait for this phase
+          if (propagateResumeFurther) node->release(phase | RELEASE_DELEGATED);
         }
-
-        // now the new flags are prepared, and we can try to install them
-        HelperNodeAtomicState oldFlags;
-        oldFlags.value = atomic_compare_and_swap((int*)&node->flags.value, currentFlags.value, newFlags.value);
-        
-        if (oldFlags.value == currentFlags.value) {
-          // CAS was sucessful, and we can exit the loop
-          compareAndSwap_failed = false;
+        else if (propagateResumeFurther) {
+          assert(numWonNodes < MAX_TREE_DEPTH);
+          wonNodes[numWonNodes++] = node;
         }
         else {
-          // lets try again, but use reuse the read value for next round
-          currentFlags = oldFlags;
+          waitNode = node;
+        }
+      }
+      
+      // we won, combine with the opponent if it signaled the same phase
+      if (accumulate && propagateResumeFurther) {
+        if (isLeft && currentFlags.bits.phaseRight == phase) {
+          value = phaser->combine(value, node->rightValue);
+        }
+        else if (!isLeft && currentFlags.bits.phaseLeft == phase) {
+          value = phaser->combine(value, node->leftValue);
         }
       }
-      while (compareAndSwap_failed);
       
-      lastNode = node;
-      node = node->getParent();
+      link = node->getLink();
+      node = TreeNode::parentOf(link);
     }
     
     if (propagateResumeFurther) {
-      notifyParticipants();
+      notifyParticipants(value);
+      releaseWonNodes(phase);
     }
     
-    //if (lock) pthread_mutex_unlock(lock);
     return propagateResumeFurther;      
   }
   
@@ -564,15 +1438,13 @@ namespace SyncTree {
    *    this is done by propagating that the node is WAIT_ONLY
    *  - do the resume, includes the notify!
    *
-   * ASSERT already acquired insertLock, this is a drop action,
-   *        it should only be called in that context and the lock
-   *        has to be acquired
+   * ASSERT executed by the combining thread, this is a drop action,
+   *        it should only be called in that context
    */
   inline bool Participant::doAllDropActions() {
-    const Mode mode          = this->mode;
-        HelperNode* node     = getParent();
-    const TreeNode* lastNode = this;
-    //int nodeId = leaveId;
+    const Mode  mode = this->mode;
+    uintptr_t   link = getLink();
+    HelperNode* node = TreeNode::parentOf(link);
     
     if (mode == WAIT_ONLY) {
       // in this case there is nothing changed,
@@ -586,14 +1458,24 @@ namespace SyncTree {
     phase = TRUNCATED_PHASE(phase + 1);
     const unsigned int myPhase = phase;
     
+    // a dropped participant does not contribute to the accumulator,
+    // but it might have to carry the values of its opponents further
+    const bool accumulate = phaser->hasAccumulator();
+    AccumulatorValue value = phaser->identity();
+    
     bool propagateResumeFurther   = true;
     bool propagateWaitOnlyFurther = true;
     HelperNodeAtomicState currentFlags;
     
     while (node && (propagateWaitOnlyFurther || propagateResumeFurther)) {
-      const bool isLeft = IsLeft(node, lastNode);
+      const bool isLeft = TreeNode::isLeftOf(link);
       bool compareAndSwap_failed = true;
-      currentFlags = node->flags;
+      currentFlags.value = atomic_load<ORDER_RELAXED>(&node->flags.value);
+      
+      if (accumulate && propagateResumeFurther) {
+        if (isLeft) node->leftValue  = value;
+        else        node->rightValue = value;
+      }
       
       bool CASSafe_propagateResumeFurther   = propagateResumeFurther;
       bool CASSafe_propagateWaitOnlyFurther = propagateWaitOnlyFurther;
@@ -636,31 +1518,44 @@ namespace SyncTree {
           CASSafe_propagateWaitOnlyFurther = newFlags.bits.waitOnlyL && newFlags.bits.waitOnlyR;
         }
         
-        // now the new flags are prepared, and we can try to install them
-        HelperNodeAtomicState oldFlags;
-        oldFlags.value = atomic_compare_and_swap((int*)&node->flags.value, currentFlags.value, newFlags.value);
+        // now the new flags are prepared, and we can try to install them,
+        // release publishes our value, acquire makes the opponent's visible
+        int64_t expected = currentFlags.value;
+        compareAndSwap_failed = not atomic_compare_exchange<ORDER_ACQ_REL>(
+                                  &node->flags.value, expected, newFlags.value);
         
-        if (oldFlags.value == currentFlags.value) {
-          // CAS was sucessful, and we can exit the loop
-          compareAndSwap_failed = false;
-        }
-        else {
-          // lets try again, but use reuse the read value for next round
-          currentFlags = oldFlags;
+        // on failure, reuse the read value for next round
+        currentFlags.value = expected;
+        
+        if (compareAndSwap_failed) {
+          node->countContention();
         }
       }
       while (compareAndSwap_failed);
       
+      // the combining thread does not wait for the phase
+      if (phaser->treeRelease && propagateResumeFurther && CASSafe_propagateResumeFurther) {
+        node->release(myPhase | RELEASE_DELEGATED);
+      }
+      
+      if (accumulate && propagateResumeFurther && CASSafe_propagateResumeFurther) {
+        if (isLeft && currentFlags.bits.phaseRight == myPhase) {
+          value = phaser->combine(value, node->rightValue);
+        }
+        else if (!isLeft && currentFlags.bits.phaseLeft == myPhase) {
+          value = phaser->combine(value, node->leftValue);
+        }
+      }
+      
       propagateResumeFurther   = CASSafe_propagateResumeFurther;
       propagateWaitOnlyFurther = CASSafe_propagateWaitOnlyFurther;
            
-      lastNode = node;
-      node     = node->getParent();
-      //nodeId >>= 1;
+      link = node->getLink();
+      node = TreeNode::parentOf(link);
     }
     
     if (propagateResumeFurther) {
-      notifyParticipants();
+      notifyParticipants(value);
     }
     
     return propagateResumeFurther;
@@ -668,8 +1563,7 @@ namespace SyncTree {
     
   /**
    * When a node is added we need to do the following:
-   *  - if it is a reused node and WAIT_ONLY, nothing changes and we return
-   *  - if it is not reused, we have to set the WAIT_ONLY flags and possibly
+   *  - if it is WAIT_ONLY, we have to set the WAIT_ONLY flags and possibly
    *    resume, this is equivalent to doing all drop actions
    *  Standard case:
    *  - if its mode is not WAIT_ONLY, we need to revoke the waitOnly flags
@@ -686,47 +1580,37 @@ namespace SyncTree {
    *            Thus, we have to make sure, that the events are ordered, by waiting until this node has the values we would expect from the last
    *            level.
    *
-   * ASSERT already acquired insertLock, this is a add action,
-   *        it should only be called in that context and the lock
-   *        has to be acquired
+   * ASSERT executed by the combining thread, this is a add action,
+   *        it should only be called in that context
    */
-  inline void Participant::doAllAddActions(const bool reusedNode) {
+  inline void Participant::doAllAddActions() {
     if (mode == WAIT_ONLY) {
-      if (reusedNode) {
-        // in this case there is nothing changed,
-        // WAIT_ONLY indicated instant resume,
-        // and this is exatly what we had for the dropped node
-        return;
-      }
-      else {
-        // it is a WAIT_ONLY node, so, what we have to do here, is basically
-        // the same that we have to do on a drop
-        doAllDropActions();
-        return;
-      }
+      // it is a WAIT_ONLY node, so, what we have to do here, is basically
+      // the same that we have to do on a drop
+      doAllDropActions();
+      return;
     }
     
     // well, now we know that it is not a WAIT_ONLY node, so we have to do
     // the stuff for the standard case
-    HelperNode* node   = getParent();
-    const TreeNode* lastNode = this;
-    
-    if (not reusedNode) {
-      // if this is a new node, then its parent phaseRight == phase
-      // by definition/initialization, the same is true for its parent
-      // and well, we dont have to bother with revoking wait-only of course (cf. few lines below)
-      
-      // this is a small optimization, but also allows to avoid special handling of this case in the code below
-      if (node) { // == insertNode.parent
-        assert(node->flags.bits.phaseRight == phase);
-        lastNode = node;
-        node = node->getParent();
-        
-        if (node) { // == insertNode.parent.parent (still not interesting, thus going to its parent)
-          assert(node->flags.bits.phaseRight == phase);
-          lastNode = node;
-          node = node->getParent();
-        }
+    uintptr_t   link = getLink();
+    HelperNode* node = TreeNode::parentOf(link);
+    
+    // our new helper's right side is at phase by initialization, and the
+    // side of the insert node's old parent was set to phase by the combiner,
+    // we dont have to bother with revoking wait-only there of course (cf. few lines below)
+    
+    // this is a small optimization, but also allows to avoid special handling of this case in the code below
+    if (node) { // == the new helper
+      assert(node->flags.bits.phaseRight == phase);
+      link = node->getLink();
+      node = TreeNode::parentOf(link);
+      
+      if (node) { // == insertNode's old parent (still not interesting, thus going to its parent)
+        assert((TreeNode::isLeftOf(link) ? node->flags.bits.phaseLeft
+                                         : node->flags.bits.phaseRight) == phase);
+        link = node->getLink();
+        node = TreeNode::parentOf(link);
       }
     }
     
@@ -740,9 +1624,9 @@ namespace SyncTree {
     unsigned int  expectedPhaseForNextLevel = 0;
     
     while (node && (setMinPhaseFurther || revokeWaitOnlyFurther)) {
-      const bool isLeftNode = IsLeft(node, lastNode);
+      const bool isLeftNode = TreeNode::isLeftOf(link);
       bool compareAndSwap_failed = true;
-      currentFlags.value = node->flags.value;
+      currentFlags.value = atomic_load<ORDER_RELAXED>(&node->flags.value);
       
       // here we want to ensure that all races with subtree
       // of the last node we touched are imposible
@@ -759,7 +1643,7 @@ namespace SyncTree {
 
           
           if (not foundExpectedValue)
-            currentFlags.value = node->flags.value;
+            currentFlags.value = atomic_load<ORDER_RELAXED>(&node->flags.value);
         }
         while (not foundExpectedValue);
       }
@@ -788,7 +1672,7 @@ namespace SyncTree {
         
         if (revokeWaitOnlyFurther) {
           
-          CASSafeResult_revokeWaitOnlyFurther = newFlags.bits.waitOnlyL &&  newFlags.bits.waitOnlyL;  // go up iff both opponents are waitOnly
+          CASSafeResult_revokeWaitOnlyFurther = newFlags.bits.waitOnlyL && newFlags.bits.waitOnlyR;  // go up iff both opponents are waitOnly
           if (isLeftNode) {
             //assert(newFlags.bits.waitOnlyL); // otherwise it should have never been propagated up the tree
             newFlags.bits.waitOnlyL = false;
@@ -802,7 +1686,7 @@ namespace SyncTree {
         
         // now the new flags are prepared, and we can try to install them
         HelperNodeAtomicState oldFlags;
-        oldFlags.value = atomic_compare_and_swap((int*)&node->flags.value, currentFlags.value, newFlags.value);
+        oldFlags.value = atomic_compare_and_swap((int64_t*)&node->flags.value, currentFlags.value, newFlags.value);
         
         if (oldFlags.value == currentFlags.value) {
           // CAS was sucessful, and we can exit the loop
@@ -818,6 +1702,7 @@ namespace SyncTree {
         else {
           // lets try again, but use reuse the read value for next round
           currentFlags = oldFlags;
+          node->countContention();
         }
       }
       while (compareAndSwap_failed);
@@ -826,27 +1711,123 @@ namespace SyncTree {
       setMinPhaseFurther    = CASSafeResult_setMinPhaseFurther;
       revokeWaitOnlyFurther = CASSafeResult_revokeWaitOnlyFurther;
       
-      lastNode = node;
-      node = node->getParent();
+      link = node->getLink();
+      node = TreeNode::parentOf(link);
     }
   }
   
   Participant::Participant(Phaser* const phaser)
-  : mode(SIGNAL_WAIT), resumed(false), phase(phaser->phase), phaser(phaser) {
+  : mode(SIGNAL_WAIT), resumed(false), dropped(false), moveRequested(false), phase(phaser->phase), phaser(phaser),
+    consumedPhase(phaser->phase), knownSlowestPhase(phaser->phase), nextWaiter(NULL),
+    waitNode(NULL), numWonNodes(0) {
+    if (phaser->topologyAware) {
+      locality.determine();
+    }
     phaser->add(this);
   }
   
   Participant::Participant(Phaser* const phaser, const Mode mode)
-  : mode(mode), resumed(false), phase(phaser->phase), phaser(phaser) {
+  : mode(mode), resumed(false), dropped(false), moveRequested(false), phase(phaser->phase), phaser(phaser),
+    consumedPhase(phaser->phase), knownSlowestPhase(phaser->phase), nextWaiter(NULL),
+    waitNode(NULL), numWonNodes(0) {
+    if (phaser->topologyAware) {
+      locality.determine();
+    }
     phaser->add(this);
   }
   
-  void Participant::notifyParticipants() const {
-    phaser->phase = TRUNCATED_PHASE(phaser->phase + 1);
+  /**
+   * Keeps the old leaf of a moving participant in the tree, until the
+   * participant is registered at its new position, it is never added.
+   */
+  Participant::Participant(const Participant* const moving)
+  : mode(moving->mode), resumed(false), dropped(false), moveRequested(false), phase(moving->phase), phaser(moving->phaser),
+    consumedPhase(moving->consumedPhase), knownSlowestPhase(moving->knownSlowestPhase), nextWaiter(NULL),
+    locality(moving->locality), waitNode(NULL), numWonNodes(0) {}
+  
+  void Participant::notifyParticipants(const AccumulatorValue value) const {
+    const unsigned int nextPhase = TRUNCATED_PHASE(phaser->phase + 1);
+    
+    if (phaser->hasAccumulator()) {
+      phaser->results[nextPhase & 1] = value;
+    }
+    
+    // the result, and the tree state of this phase, are published with the phase
+    atomic_store<ORDER_RELEASE>(&phaser->phase, nextPhase);
+    WAIT_POLICY::wake(&phaser->phase);
+    
+    // the global phase bounds the slowest waiter, too
+    if (phaser->bound != UNBOUNDED) {
+      WAIT_POLICY::wake(&phaser->bound);
+    }
+  }
+  
+  AccumulatorValue Participant::next() {
+    if (mode == WAIT_ONLY) {
+      // WAIT_ONLY participants do not resume, thus they advance here
+      const unsigned int consumed = consumedPhase;
+      phase = TRUNCATED_PHASE(phase + 1);
+      awaitNextPhase();
+      atomic_store<ORDER_RELEASE>(&consumedPhase, phase);
+      
+      if (phaser->bound != UNBOUNDED) {
+        phaser->waiterConsumed(consumed);
+      }
+    }
+    else if (mode != SIGNAL_ONLY) {
+      awaitNextPhase();
+    }
+    
+    stats_add(STAT_EPISODES);
+
+    // we are between two phases, the only moment we can change our leaf
+    if (atomic_load<ORDER_RELAXED>(&moveRequested)) {
+      moveRequested = false;
+      phaser->move(this);
+    }
+
+    // now do the local sense reversal (global is already done on resume/synchronization)
+    resumed = false;
+    
+    // awaitNextPhase() acquired the result together with the phase
+    if (phaser->hasAccumulator()) {
+      return phaser->results[phase & 1];
+    }
+    
+    AccumulatorValue none;
+    none.asInt64 = 0;
+    return none;
   }
   
   bool Participant::drop() {
+    if (dropped) {
+      return false;
+    }
+    dropped = true;
+    
+    // resumed, but not waiting anymore, whoever lost against us has to fall back
+    releaseWonNodes(phase | RELEASE_DELEGATED);
+    waitNode = NULL;
+    
     return phaser->drop(this);
   }
   
+  /**
+   * Block a SIGNAL_ONLY participant until signaling the next phase keeps it
+   * within the bound. The slowest waiter is only reread when the known
+   * value does not allow to proceed, and after that only after a wake.
+   */
+  void Participant::awaitBound() {
+    const unsigned int nextPhase = TRUNCATED_PHASE(phase + 1);
+    
+    // waiters wake us on the bound, whenever they consumed a phase
+    WAIT_POLICY waiter(&phaser->bound);
+    while (TRUNCATED_PHASE(nextPhase - knownSlowestPhase) > phaser->bound) {
+      knownSlowestPhase = phaser->slowestWaiterPhase();
+      if (TRUNCATED_PHASE(nextPhase - knownSlowestPhase) > phaser->bound) {
+        waiter.wait();
+      }
+    }
+  }
+  
 }
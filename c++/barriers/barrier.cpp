@@ -22,6 +22,7 @@
  */
 
 #include "barrier.h"
+#include "../misc/trace.h"
 
 
 barrier_t* barrier_create(int num_participants) {
@@ -34,9 +35,9 @@ void barrier_finalize_initialization(barrier_t* const barrier) {
 }
 
 participant_t* participant_create(barrier_t* const barrier) {
-  return new participant_t(barrier);
+  return traced_add<participant_t>(barrier);
 }
 
 void participant_barrier(participant_t* participant) {
-  participant->barrier();
+  TRACED(TRACE_BARRIER, participant->barrier());
 }
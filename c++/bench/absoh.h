@@ -21,17 +21,26 @@
  * THE SOFTWARE.
  */
 
+#include "episodes.h"
+
 typedef void *(*pthread_routine)(void*);
 
 template <class BarrierClass, typename ParticipantType>
 class ABSOH {
 public:
   
-  ABSOH(const int numParticipants)
-    : outerDelay(500),
-      innerReps(1000),
+  static const size_t DEFAULT_DELAY = 500;
+  static const size_t DEFAULT_REPS  = 1000;
+  
+  ABSOH(const int    numParticipants,
+        const size_t outerDelay = DEFAULT_DELAY,
+        const size_t innerReps  = DEFAULT_REPS)
+    : outerDelay(outerDelay),
+      innerReps(innerReps),
       numParticipants(numParticipants),
       initalization_finished(false),
+      finishedThreads(0),
+      episodes(NULL),
       barrier(new BarrierClass(numParticipants))
   {
     printPreamble();
@@ -49,6 +58,10 @@ public:
   BarrierClass* getBarrier() { return barrier; }
   
   volatile bool initalization_finished;
+  volatile int  finishedThreads;
+  
+  // only allocated for the barrier measurement
+  EpisodeRecorder* episodes;
   
 private:
   void printPreamble();
@@ -33,12 +33,15 @@
 #include <cmath> 
 
 #include <pthread.h>
+#include <sched.h>
 
 #ifdef __tile__
   #include <tmc/cpus.h>
 #endif
 
 #include "../misc/get_clock.h"
+#include "../misc/stats.h"
+#include "../misc/trace.h"
 #include "../misc/atomic.h"
 #include "../misc/misc.h"
 
@@ -59,12 +62,16 @@ void ABSOH<BarrierClass, ParticipantType>::printPreamble() {
 
 template <class BarrierClass, typename ParticipantType>
 void ABSOH<BarrierClass, ParticipantType>::delay(int delayLength) {
+#if CALIBRATED_DELAY
+  delay_ns(delayLength);
+#else
   int   i;
   float a = 0.0; 
   
   for (i = 0;  i < delayLength;  i++)  a += i; 
   
   if  (a < 0) printf("%f \n", a);
+#endif
 } 
 
 
@@ -79,12 +86,12 @@ void ABSOH<BarrierClass, ParticipantType>::measureReferenceTime() {
   printf("Computing reference time 1\n"); 
   
   for (k = 0; k <= OUTERREPS; k++) {
-    start = get_clock(); 
+    start = get_clock_ns(); 
 		//this probably gets optimized away and screws our reference time
 		//not so bad since it should be very small ...
     for (j = 0; j < innerReps; j++) {
     }
-    stop = get_clock();
+    stop = get_clock_ns();
   }
   
   calculateAndPrintStatistics(&meantime, &sd);
@@ -97,15 +104,20 @@ void ABSOH<BarrierClass, ParticipantType>::measureReferenceTime() {
 
 
 template <class BarrierClass, typename ParticipantType>
-void innerLoop(ABSOH<BarrierClass, ParticipantType>* absoh, BarrierClass* barrier, ParticipantType* const participant) {
+void innerLoop(ABSOH<BarrierClass, ParticipantType>* absoh, BarrierClass* barrier, ParticipantType* const participant, const size_t id) {
+  EpisodeRecorder* const episodes = absoh->episodes;
+  
   for (size_t j = 0; j < absoh->innerReps; j++) {
 		if(DEBUG) printf("thread> Starting innerloop %zu\n", j);
 #if USE_TWO_PHASE
-    participant->resume();
-    participant->next();
+    TRACED(TRACE_RESUME, participant->resume());
+    episodes->arrive(id);
+    TRACED(TRACE_NEXT, participant->next());
 #else
-    participant->barrier();
+    episodes->arrive(id);
+    TRACED(TRACE_BARRIER, participant->barrier());
 #endif
+    episodes->depart(id);
   }
 }
 
@@ -139,7 +151,10 @@ void* _benchmark(void* threadParam) {
   
   BarrierClass* const barrier = absoh->getBarrier();
   
-  ParticipantType* const participant = new ParticipantType(barrier); //this registers the participant on the barrier
+  trace_attach(param->id);
+  stats_attach(param->id);
+  ParticipantType* const participant = traced_add<ParticipantType>(barrier); //this registers the participant on the barrier
+  const size_t id = param->id;
   
   memory_fence();  // make sure everything is done
   
@@ -152,12 +167,15 @@ void* _benchmark(void* threadParam) {
   size_t k;
   for (k = 0; k <= OUTERREPS; k++){
 		if(DEBUG) printf("thread> Starting outerloop %zu\n", k);
-    innerLoop(absoh, barrier, participant);
+    innerLoop(absoh, barrier, participant, id);
 		if(DEBUG) printf("thread> Ended outerloop %zu\n", k);
     
     ABSOH<BarrierClass, ParticipantType>::delay(absoh->outerDelay);
   }
   
+  // lets the main thread know, that this thread did its last wait
+  atomic_add_and_fetch((int*)&absoh->finishedThreads, 1);
+  
   delete param;
   pthread_exit(NULL);
 }
@@ -233,22 +251,27 @@ void ABSOH<BarrierClass, ParticipantType>::measureBarrierPerformance() {
   printf("Computing BARRIER time\n");
   
   
-  ParticipantType* const participant = new ParticipantType(barrier);
+  trace_prepare(numParticipants);
+  trace_attach(0);
+  stats_attach(0);
+  ParticipantType* const participant = traced_add<ParticipantType>(barrier);
 
+  // the first outer repetition is only the warmup
+  episodes = new EpisodeRecorder(numParticipants, (OUTERREPS + 1) * innerReps);
   
   spawnThreads();
 
   for (k = 0; k <= OUTERREPS; k++){
-    start  = get_clock(); 
+    start  = get_clock_ns(); 
 		if(DEBUG) printf("main> Starting outerloop %zu\n", k);
     
-    innerLoop(this, barrier, participant);
+    innerLoop(this, barrier, participant, 0);
 
 		if(DEBUG) printf("main> Stopping outerloop %zu\n", k);
    
-		stop = get_clock();
+		stop = get_clock_ns();
 	  //costPerBarrier = TotalBarrierExecutionTime / numBarriers	
-    times[k] = (stop - start) * 1.0e6 / (double) innerReps;
+    times[k] = (stop - start) * 1.0e-3 / (double) innerReps;
   
 		delay(outerDelay);
   }
@@ -260,6 +283,11 @@ void ABSOH<BarrierClass, ParticipantType>::measureBarrierPerformance() {
   
   printf("BARRIER overhead =                       %f microseconds +/- %f\n", meantime-reftime, CONF95*(sd+refsd));
   
+  // the counters are only complete after all threads did their last wait
+  while (finishedThreads != (int)numParticipants - 1) { sched_yield(); }
+  
+  episodes->report(innerReps);
+  stats_report();
 }
 
 template <class BarrierClass, typename ParticipantType>
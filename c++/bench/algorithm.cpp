@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  Instantiates one benchmark for one barrier, and registers it with the
+ *  benchmark driver. The build environment sets:
+ *    BENCH_ALGORITHM_HEADER  the barrier's header, e.g., "../barriers/SyncTreePhaser.h"
+ *    BENCH_ALGORITHM_NAME    the name to select it, e.g., "SyncTreePhaser"
+ *    BENCH_NAME              the name of the benchmark, e.g., "epcc-simple"
+ *    BENCH_KIND              BENCH_EPCC, BENCH_ABSOH, BENCH_LIOH, BENCH_DYNAMIC, BENCH_REDUCE, or BENCH_BOUNDED
+ *    BENCH_NAMESPACE         a name unique for the pair
+ *
+ *  The barrier and the benchmark are compiled into BENCH_NAMESPACE, since
+ *  several barriers define classes of the same name, and the benchmarks
+ *  define the same globals. All system and helper headers are included
+ *  first, their include guards keep them out of the namespace.
+ */
+
+#define BENCH_EPCC    1
+#define BENCH_ABSOH   2
+#define BENCH_LIOH    3
+#define BENCH_DYNAMIC 4
+#define BENCH_REDUCE  5
+#define BENCH_BOUNDED 6
+
+#if !defined(BENCH_ALGORITHM_HEADER) || !defined(BENCH_ALGORITHM_NAME) || \
+    !defined(BENCH_NAME) || !defined(BENCH_KIND) || !defined(BENCH_NAMESPACE)
+  #error The build environment has to define the barrier and the benchmark, see above
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <new>
+#include <memory>
+#include <vector>
+#include <iostream>
+
+#ifdef __tile__
+  #include <tmc/cpus.h>
+#endif
+
+#include "../misc/misc.h"
+#include "../misc/atomic.h"
+#include "../misc/assert.h"
+#include "../misc/lock.h"
+#include "../misc/align.h"
+#include "../misc/pool.h"
+#include "../misc/wait.h"
+#include "../misc/topology.h"
+#include "../misc/get_clock.h"
+#include "../misc/stats.h"
+#include "../misc/trace.h"
+#include "../misc/histogram.h"
+#include "episodes.h"
+
+#include "driver.h"
+
+#ifndef BENCH_MAX_PARTICIPANTS
+  #define BENCH_MAX_PARTICIPANTS 64
+#endif
+
+/**
+ * Barriers sized at compile time use NUM_PARTICIPANTS in their template
+ * arguments, here, they refer to the template parameter of Algorithm below.
+ */
+#undef  NUM_PARTICIPANTS
+#undef  LOG2_NUM_PARTICIPANTS
+#define NUM_PARTICIPANTS      BenchParticipants
+#define LOG2_NUM_PARTICIPANTS (CeilLog2<BenchParticipants>::value)
+
+template<int N>
+struct CeilLog2 {
+  enum { value = 1 + CeilLog2<(N + 1) / 2>::value };
+};
+
+template<>
+struct CeilLog2<1> {
+  enum { value = 0 };
+};
+
+template<class A, class B>
+struct SameType {
+  enum { value = false };
+};
+
+template<class A>
+struct SameType<A, A> {
+  enum { value = true };
+};
+
+namespace BENCH_NAMESPACE {
+  
+  #include BENCH_ALGORITHM_HEADER
+  
+#if   BENCH_KIND == BENCH_EPCC
+  #include "epcc.h"
+#elif BENCH_KIND == BENCH_ABSOH
+  #include "absoh.h"
+#elif BENCH_KIND == BENCH_LIOH
+  #include "lioh.h"
+#elif BENCH_KIND == BENCH_DYNAMIC
+  #include "dynamic.h"
+#elif BENCH_KIND == BENCH_REDUCE
+  #include "reduce.h"
+#elif BENCH_KIND == BENCH_BOUNDED
+  #include "bounded.h"
+#endif
+  
+  template<int BenchParticipants>
+  struct Algorithm {
+    typedef BARRIER BarrierType;
+    typedef typename BENCH_NAMESPACE::PARTICIPANT ParticipantType;
+  };
+  
+  template<class A>
+  void runWith(const BenchmarkSettings& settings, const bool measureRegistrations) {
+    typedef typename A::BarrierType     B;
+    typedef typename A::ParticipantType P;
+    
+#if   BENCH_KIND == BENCH_EPCC
+    EPCC<B, P> benchmark(settings.numParticipants,
+                         settings.delayOr(EPCC<B, P>::DEFAULT_DELAY),
+                         settings.repsOr (EPCC<B, P>::DEFAULT_REPS));
+#elif BENCH_KIND == BENCH_ABSOH
+    ABSOH<B, P> benchmark(settings.numParticipants,
+                          settings.delayOr(ABSOH<B, P>::DEFAULT_DELAY),
+                          settings.repsOr (ABSOH<B, P>::DEFAULT_REPS));
+#elif BENCH_KIND == BENCH_LIOH
+    LIOH<B, P> benchmark(settings.numParticipants,
+                         settings.delayOr(LIOH<B, P>::DEFAULT_DELAY),
+                         settings.repsOr (LIOH<B, P>::DEFAULT_REPS));
+#elif BENCH_KIND == BENCH_REDUCE
+    REDUCE<B, P> benchmark(settings.numParticipants,
+                           settings.delayOr(REDUCE<B, P>::DEFAULT_DELAY),
+                           settings.repsOr (REDUCE<B, P>::DEFAULT_REPS));
+#elif BENCH_KIND == BENCH_BOUNDED
+    BOUNDED<B, P> benchmark(settings.numParticipants,
+                            settings.delayOr(BOUNDED<B, P>::DEFAULT_DELAY),
+                            settings.repsOr (BOUNDED<B, P>::DEFAULT_REPS));
+#elif BENCH_KIND == BENCH_DYNAMIC
+    DYNPAR<B, P> benchmark(settings.numParticipants,
+                           settings.delayOr(DYNPAR<B, P>::DEFAULT_DELAY));
+    
+    if (measureRegistrations) {
+      benchmark.measureRegistrationThroughput();
+      return;
+    }
+#endif
+    
+    (void)measureRegistrations;
+    
+    if (!settings.skipReferenceTime)
+      benchmark.measureReferenceTime();
+    benchmark.measureBarrierPerformance();
+  }
+  
+  /**
+   * Selects the instance of the barrier for the requested number of
+   * participants, all of them up to BENCH_MAX_PARTICIPANTS are instantiated.
+   */
+  template<int N>
+  struct CountDispatch {
+    static void run(const BenchmarkSettings& settings, const bool measureRegistrations) {
+      if (settings.numParticipants == N) {
+        runWith< Algorithm<N> >(settings, measureRegistrations);
+      }
+      else {
+        CountDispatch<N - 1>::run(settings, measureRegistrations);
+      }
+    }
+  };
+  
+  template<>
+  struct CountDispatch<0> {
+    static void run(const BenchmarkSettings&, const bool) {}
+  };
+  
+  /**
+   * Barriers sized at runtime are the same type for every count,
+   * thus, they are only instantiated once.
+   */
+  template<bool SizedAtCompileTime>
+  struct Dispatch {
+    static const size_t maxParticipants = BENCH_MAX_PARTICIPANTS;
+    
+    static void run(const BenchmarkSettings& settings, const bool measureRegistrations) {
+      CountDispatch<BENCH_MAX_PARTICIPANTS>::run(settings, measureRegistrations);
+    }
+  };
+  
+  template<>
+  struct Dispatch<false> {
+#if BENCH_KIND == BENCH_DYNAMIC
+    static const size_t maxParticipants = NUM_THREADS;
+#else
+    static const size_t maxParticipants = 0;
+#endif
+    
+    static void run(const BenchmarkSettings& settings, const bool measureRegistrations) {
+      runWith< Algorithm<1> >(settings, measureRegistrations);
+    }
+  };
+  
+  typedef Dispatch<not SameType<Algorithm<1>::BarrierType, Algorithm<2>::BarrierType>::value> AlgorithmDispatch;
+  
+  void run(const BenchmarkSettings& settings) {
+    AlgorithmDispatch::run(settings, false);
+  }
+  
+  BenchmarkRegistration registration(BENCH_ALGORITHM_NAME, BENCH_NAME,
+                                     AlgorithmDispatch::maxParticipants, &run);
+  
+#if BENCH_KIND == BENCH_DYNAMIC
+  void runRegistrations(const BenchmarkSettings& settings) {
+    AlgorithmDispatch::run(settings, true);
+  }
+  
+  BenchmarkRegistration registrationsRegistration(BENCH_ALGORITHM_NAME, "registrations",
+                                                  AlgorithmDispatch::maxParticipants, &runRegistrations);
+#endif
+  
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2010 Stijn Verhaegen, Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The BOUNDED benchmark runs a bounded phaser as a producer/consumer queue:
+ * the first half of the participants are SIGNAL_ONLY producers, the others
+ * WAIT_ONLY consumers, which work twice as long per phase, so that the
+ * producers keep running into the bound. It measures the producers' time
+ * per phase, and verifies that no producer gets more than `bound` phases
+ * ahead of any consumer, and that no consumer completes a phase before
+ * every producer signaled it.
+ * Only barriers supporting bounded SyncTree phasers are supported, cf.
+ * BOUNDED_BARRIERS in barrier.mk.
+ */
+
+typedef void *(*pthread_routine)(void*);
+
+template <class BarrierClass, typename ParticipantType>
+class BOUNDED {
+public:
+  
+  static const size_t       DEFAULT_DELAY = 500;
+  static const size_t       DEFAULT_REPS  = 10000;
+  static const unsigned int DEFAULT_BOUND = 4;
+  
+  BOUNDED(const int          numParticipants,
+          const size_t       delayLength = DEFAULT_DELAY,
+          const size_t       innerReps   = DEFAULT_REPS,
+          const unsigned int bound       = DEFAULT_BOUND)
+    : delayLength(delayLength),
+      innerReps(innerReps),
+      numParticipants(numParticipants),
+      numProducers(numParticipants / 2),
+      bound(bound),
+      initalization_finished(false),
+      finishedThreads(0),
+      errors(0),
+      maxLead(0),
+      produced(new volatile size_t[numParticipants]),
+      participants(new ParticipantType*[numParticipants]),
+      barrier(new BarrierClass(numParticipants))
+  {
+    if (numProducers == 0) {
+      fprintf(stderr, "The bounded benchmark needs at least one producer and one consumer\n");
+      exit(1);
+    }
+    
+    barrier->setBound(bound);
+    
+    for (size_t i = 0; i < this->numParticipants; i++) {
+      produced[i]     = 0;
+      participants[i] = NULL;
+    }
+    
+    printPreamble();
+  }
+  
+  void measureReferenceTime();
+  void measureBarrierPerformance();
+  
+  static void delay(int delayLength);
+  
+  inline bool isProducer(const size_t id) const { return id < numProducers; }
+  
+  /**
+   * One phase of a participant, which is a producer or a consumer by its id.
+   * Counts an error if it got ahead of the other side.
+   */
+  inline void step(ParticipantType* const participant, const size_t id, const size_t phase);
+  
+  const size_t       delayLength;
+  const size_t       innerReps;
+  const size_t       numParticipants;
+  const size_t       numProducers;
+  const unsigned int bound;
+  
+  BarrierClass* getBarrier() { return barrier; }
+  
+  volatile bool initalization_finished;
+  volatile int  finishedThreads;
+  volatile int  errors;
+  volatile int  maxLead;
+  
+  // the number of phases each producer published, set before it resumes
+  volatile size_t* const produced;
+  ParticipantType** const participants;
+  
+private:
+  void printPreamble();
+  void calculateAndPrintStatistics(double *mtp, double *sdp);
+  
+  void spawnThreads();
+  
+  BarrierClass* const barrier;
+};
+
+// we need the implementation in the header
+#include "bounded.impl.h"
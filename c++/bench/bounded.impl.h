@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2010 Stijn Verhaegen, Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath> 
+
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef __tile__
+  #include <tmc/cpus.h>
+#endif
+
+#include "../misc/get_clock.h"
+#include "../misc/stats.h"
+#include "../misc/trace.h"
+#include "../misc/atomic.h"
+#include "../misc/misc.h"
+
+
+const size_t OUTERREPS = 1;
+const double CONF95    = 1.96;
+
+
+double times[OUTERREPS+1], reftime, refsd; 
+
+template <class BarrierClass, typename ParticipantType>
+void BOUNDED<BarrierClass, ParticipantType>::printPreamble() {
+  printf(" Running bounded phaser benchmarks on %zu thread(s)\n", numParticipants);
+  printf("   delayLength: %zu%s\n", delayLength, CALIBRATED_DELAY ? " ns" : "");
+  printf("   innerReps: %zu\n",   innerReps);
+  printf("   producers: %zu, consumers: %zu\n", numProducers, numParticipants - numProducers);
+  printf("   bound: %u\n", bound);
+}
+
+
+template <class BarrierClass, typename ParticipantType>
+void BOUNDED<BarrierClass, ParticipantType>::delay(int delayLength) {
+#if CALIBRATED_DELAY
+  delay_ns(delayLength);
+#else
+  int   i;
+  float a = 0.0; 
+  
+  for (i = 0;  i < delayLength;  i++)  a += i; 
+  
+  if  (a < 0) printf("%f \n", a);
+#endif
+} 
+
+
+template <class BarrierClass, typename ParticipantType>
+void BOUNDED<BarrierClass, ParticipantType>::measureReferenceTime() {
+  size_t j, k;
+  uint64_t start;
+  double meantime, sd;
+  
+  printf("\n");
+  printf("--------------------------------------------------------\n");
+  printf("Computing reference time 1\n"); 
+  
+  for (k = 0; k <= OUTERREPS; k++) {
+    start = get_clock_ns(); 
+    for (j = 0; j < innerReps; j++) {
+      delay(delayLength); 
+    }
+    times[k] = (get_clock_ns() - start) * 1.0e-3 / (double) innerReps;
+  }
+  
+  calculateAndPrintStatistics(&meantime, &sd);
+  
+  printf("Reference_time_1 =                        %f microseconds +/- %f\n", meantime, CONF95*sd);
+  
+  reftime = meantime;
+  refsd = sd;  
+}
+
+
+template <class BarrierClass, typename ParticipantType>
+inline void BOUNDED<BarrierClass, ParticipantType>::step(ParticipantType* const participant, const size_t id, const size_t phase) {
+  if (isProducer(id)) {
+    delay(delayLength);
+    
+    atomic_store<ORDER_RELEASE>(&produced[id], phase + 1);
+    TRACED(TRACE_RESUME, participant->resume());
+    
+    // the consumers' progress only grows, thus, it is at least what the
+    // producer saw when it passed the bound
+    for (size_t i = numProducers; i < numParticipants; i++) {
+      const int lead = TRUNCATED_PHASE(participant->phase - participants[i]->consumedPhase);
+      
+      if (lead > (int)bound) {
+        atomic_add_and_fetch((int*)&errors, 1);
+      }
+      
+      int seen = maxLead;
+      while (lead > seen && !atomic_compare_and_swap_bool((int*)&maxLead, seen, lead)) {
+        seen = maxLead;
+      }
+    }
+  }
+  else {
+    delay(2 * delayLength);
+    
+    TRACED(TRACE_NEXT, participant->next());
+    
+    for (size_t i = 0; i < numProducers; i++) {
+      if (atomic_load<ORDER_ACQUIRE>(&produced[i]) < phase + 1) {
+        atomic_add_and_fetch((int*)&errors, 1);
+      }
+    }
+  }
+}
+
+
+template <class BarrierClass, typename ParticipantType>
+void innerLoop(BOUNDED<BarrierClass, ParticipantType>* bounded, ParticipantType* const participant, const size_t id, size_t& phase) {
+  for (size_t j = 0; j < bounded->innerReps; j++) {
+    bounded->step(participant, id, phase);
+    phase++;
+  }
+}
+
+
+class ThreadParam {
+public:
+  ThreadParam() : obj(NULL), id(0), initialized(false) {}
+           void*  obj;
+           size_t id;
+  volatile bool   initialized;
+  
+#ifdef __tile__
+           int    cpu_id;
+#endif
+};
+
+
+template <class BarrierClass, typename ParticipantType>
+void* _benchmark(void* threadParam) {
+  ThreadParam* param = (ThreadParam*)threadParam;
+  BOUNDED<BarrierClass, ParticipantType>* bounded = (BOUNDED<BarrierClass, ParticipantType>*)param->obj;
+  
+  // set affinitiy of this thread
+#ifdef __tile__
+  if (tmc_cpus_set_my_cpu(param->cpu_id) != 0) {
+    perror("tmc_cpus_set_my_cpu(..) failed\n");
+    exit(1);
+  }
+#endif
+  
+  BarrierClass* const barrier = bounded->getBarrier();
+  const size_t id = param->id;
+  
+  trace_attach(id);
+  stats_attach(id);
+  ParticipantType* const participant = traced_add<ParticipantType>(barrier,
+      bounded->isProducer(id) ? SyncTree::SIGNAL_ONLY : SyncTree::WAIT_ONLY);
+  bounded->participants[id] = participant;
+  
+  memory_fence();  // make sure everything is done
+  
+  // signal that this thread has registered with the barrier
+  param->initialized = true;
+  
+  // synchronize all participants before the actual benchmark
+  while (!bounded->initalization_finished) { sched_yield(); }
+  
+  size_t phase = 0;
+  size_t k;
+  for (k = 0; k <= OUTERREPS; k++){
+    innerLoop(bounded, participant, id, phase);
+  }
+  
+  // lets the main thread know, that all phases were checked
+  atomic_add_and_fetch((int*)&bounded->finishedThreads, 1);
+  
+  delete param;
+  pthread_exit(NULL);
+}
+
+#ifdef __tile__
+int _find_next_cpu(cpu_set_t* cpus, int& next_cpu) {
+  next_cpu++;
+  while (next_cpu < TMC_CPUS_MAX_COUNT && !tmc_cpus_has_cpu(cpus, next_cpu)) {
+    next_cpu++;
+  }
+  return next_cpu;
+}
+#endif
+
+template <class BarrierClass, typename ParticipantType>
+void BOUNDED<BarrierClass, ParticipantType>::spawnThreads() {
+  pthread_t threads[numParticipants];   // thread handles
+
+  // on the tilera we can set the thread affinity, but we need some infos for that
+#ifdef __tile__
+  cpu_set_t cpus;
+  if (tmc_cpus_get_online_cpus(&cpus)) {
+    perror("tmc_cpus_get_online_cpus failed\n");
+    exit(1);
+  }
+  
+  int next_cpu = -1;  // to make sure the first found cpu has id 0
+  _find_next_cpu(&cpus, next_cpu);  //should be 0 or something else if that tile is not available to linux
+  
+  if (tmc_cpus_set_my_cpu(next_cpu) != 0) {
+    perror("tmc_cpus_set_my_cpu(..) failed\n");
+    exit(1);
+  }
+#endif
+  
+  for (size_t i = 1; i < numParticipants; i++) {
+    ThreadParam* param = new ThreadParam();
+    param->obj = (void*)this;
+    param->id  = i;
+#ifdef __tile__
+    // find a cpu and give it to the new thread
+    param->cpu_id = _find_next_cpu(&cpus, next_cpu);
+#endif
+    
+    int rc = pthread_create(&threads[i], NULL, 
+                            _benchmark<BarrierClass, ParticipantType>,
+                            (void*)param);
+    
+    if (rc){
+      printf("ERROR; return code from pthread_create() is %d\n", rc);
+      exit(-1);
+    }
+    
+    // make sure the spawned thread registerd on the barrier
+    while (!param->initialized) { sched_yield(); }
+  }
+  
+  barrier->finalize_initialization();
+  memory_fence();
+  initalization_finished = true;
+}
+
+template <class BarrierClass, typename ParticipantType>
+void BOUNDED<BarrierClass, ParticipantType>::measureBarrierPerformance() {
+  size_t k; 
+  uint64_t start; 
+  double meantime, sd;
+  
+  printf("\n");
+  printf("--------------------------------------------------------\n");
+  printf("Computing BOUNDED time\n");
+  
+  trace_prepare(numParticipants);
+  trace_attach(0);
+  stats_attach(0);
+  
+  // the main thread is the first producer
+  ParticipantType* const participant = traced_add<ParticipantType>(barrier, SyncTree::SIGNAL_ONLY);
+  participants[0] = participant;
+  
+  spawnThreads();
+  
+  size_t phase = 0;
+  for (k = 0; k <= OUTERREPS; k++){
+    start  = get_clock_ns(); 
+    
+    innerLoop(this, participant, 0, phase);
+    
+    times[k] = (get_clock_ns() - start) * 1.0e-3 / (double) innerReps;
+  }
+  
+  // the consumers check the last phases after the producers are done
+  while (finishedThreads != (int)numParticipants - 1) { sched_yield(); }
+  
+  
+  calculateAndPrintStatistics(&meantime, &sd);
+  
+  printf("BOUNDED time =                           %f microseconds +/- %f\n", meantime, CONF95*sd);
+  
+  printf("BOUNDED overhead =                       %f microseconds +/- %f\n", meantime-reftime, CONF95*(sd+refsd));
+  
+  printf("BOUNDED max lead =                       %d\n", maxLead);
+  
+  printf("BOUNDED errors =                         %d\n", errors);
+  
+  stats_report();
+  
+  if (errors != 0) {
+    fprintf(stderr, "%d phases got ahead of the bound %u or of the producers\n",
+            errors, bound);
+    exit(1);
+  }
+}
+
+template <class BarrierClass, typename ParticipantType>
+void BOUNDED<BarrierClass, ParticipantType>::calculateAndPrintStatistics(double *mtp, double *sdp) {
+  
+  double meantime, totaltime, sumsq, mintime, maxtime, sd, cutoff; 
+  
+  size_t i, nr; 
+  
+  mintime = 1.0e10;
+  maxtime = 0.;
+  totaltime = 0.;
+  
+  for (i = 1; i <= OUTERREPS; i++){
+    mintime = (mintime < times[i]) ? mintime : times[i];
+    maxtime = (maxtime > times[i]) ? maxtime : times[i];
+    totaltime +=times[i]; 
+  } 
+  
+  meantime  = totaltime / OUTERREPS;
+  sumsq = 0; 
+  
+  for (i = 1; i <= OUTERREPS; i++){
+    sumsq += (times[i]-meantime)* (times[i]-meantime); 
+  }
+
+#if OUTERREPS > 1
+    sd = sqrt(sumsq/(OUTERREPS-1));
+#else
+    sd = 0;
+#endif
+
+  
+  cutoff = 3.0 * sd; 
+  
+  nr = 0; 
+  
+  for (i=1; i <= OUTERREPS; i++){
+    if ( fabs(times[i]-meantime) > cutoff ) nr ++; 
+  }
+  
+  printf("\n"); 
+  printf("Sample_size       Average     Min         Max          S.D.          Outliers\n");
+  printf(" %zu                %f   %f   %f    %f      %zu\n",OUTERREPS, meantime, mintime, maxtime, sd, nr); 
+  printf("\n");
+  
+  *mtp = meantime; 
+  *sdp = sd; 
+  
+} 
+
+
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <set>
+
+#include "driver.h"
+
+/*
+ This is the main of the benchmark driver, which contains all barriers and
+ benchmarks selected by the build, cf. bench/algorithm.cpp.
+ */
+
+#ifndef SKIP_REFERENCE_TIME
+  #define SKIP_REFERENCE_TIME 0
+#endif
+
+static void printUsage(const char* const name) {
+  printf("usage: %s -a <barrier> -b <benchmark> -n <threads> [-d <delay>] [-r <reps>] [-s] [-R]\n", name);
+  printf("       %s -l\n", name);
+  printf("  -a  the barrier, e.g., SyncTreePhaser\n");
+  printf("  -b  epcc, epcc-simple, absoh, lioh, dynamic, registrations, reduce, or bounded\n");
+  printf("  -n  the number of participating threads\n");
+  printf("  -d  the delay, defaults to the benchmark's default\n");
+  printf("  -r  the inner repetitions, defaults to the benchmark's default\n");
+  printf("  -s  skip the reference time measurement\n");
+  printf("  -R  measure the reference time\n");
+  printf("  -l  list all barriers and their benchmarks\n");
+}
+
+static void printAlgorithms() {
+  const std::vector<BenchmarkEntry>& entries = benchmark_registry();
+  
+  std::set<std::string> algorithms;
+  for (size_t i = 0; i < entries.size(); i++) {
+    algorithms.insert(entries[i].algorithm);
+  }
+  
+  for (std::set<std::string>::const_iterator a = algorithms.begin(); a != algorithms.end(); ++a) {
+    printf("%s:", a->c_str());
+    for (size_t i = 0; i < entries.size(); i++) {
+      if (*a == entries[i].algorithm) {
+        printf(" %s", entries[i].benchmark);
+      }
+    }
+    printf("\n");
+  }
+}
+
+static bool parseSize(const char* const arg, size_t& value) {
+  char* end;
+  const long long parsed = strtoll(arg, &end, 10);
+  if (*arg == '\0' || *end != '\0' || parsed < 0) {
+    return false;
+  }
+  value = (size_t)parsed;
+  return true;
+}
+
+int main(int argc, const char* argv[]) {
+  const char* algorithm = NULL;
+  const char* benchmark = NULL;
+  
+  BenchmarkSettings settings;
+  settings.numParticipants   = 0;
+  settings.delay             = 0;
+  settings.reps              = 0;
+  settings.hasDelay          = false;
+  settings.hasReps           = false;
+  settings.skipReferenceTime = SKIP_REFERENCE_TIME;
+  
+  for (int i = 1; i < argc; i++) {
+    const bool hasValue = i + 1 < argc;
+    
+    if      (strcmp(argv[i], "-l") == 0) { printAlgorithms(); return 0; }
+    else if (strcmp(argv[i], "-s") == 0) { settings.skipReferenceTime = true;  }
+    else if (strcmp(argv[i], "-R") == 0) { settings.skipReferenceTime = false; }
+    else if (strcmp(argv[i], "-a") == 0 && hasValue) { algorithm = argv[++i]; }
+    else if (strcmp(argv[i], "-b") == 0 && hasValue) { benchmark = argv[++i]; }
+    else if (strcmp(argv[i], "-n") == 0 && hasValue && parseSize(argv[i + 1], settings.numParticipants)) { i++; }
+    else if (strcmp(argv[i], "-d") == 0 && hasValue && parseSize(argv[i + 1], settings.delay)) { settings.hasDelay = true; i++; }
+    else if (strcmp(argv[i], "-r") == 0 && hasValue && parseSize(argv[i + 1], settings.reps))  { settings.hasReps  = true; i++; }
+    else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+  
+  if (algorithm == NULL || benchmark == NULL || settings.numParticipants == 0) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  
+  const BenchmarkEntry* const entry = benchmark_find(algorithm, benchmark);
+  if (entry == NULL) {
+    fprintf(stderr, "The %s benchmark is not available for %s, see -l\n", benchmark, algorithm);
+    return 1;
+  }
+  
+  if (entry->maxParticipants != 0 && settings.numParticipants > entry->maxParticipants) {
+    fprintf(stderr, "%s supports at most %zu threads in the %s benchmark\n",
+            algorithm, entry->maxParticipants, benchmark);
+    return 1;
+  }
+  
+  printf("Barrier: %s, benchmark: %s\n", algorithm, benchmark);
+  entry->run(settings);
+  
+  pthread_exit(NULL);
+  return 0;
+}
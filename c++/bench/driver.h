@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  The benchmark driver combines all barriers and benchmarks in a single
+ *  binary. Every pair of barrier and benchmark is compiled separately from
+ *  bench/algorithm.cpp, and registers itself here, the driver selects one
+ *  of them, the number of threads, the delay, and the repetitions at runtime.
+ */
+
+#ifndef __DRIVER_H__
+#define __DRIVER_H__
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+/**
+ * Delay and repetitions are only applied if they are given, otherwise the
+ * benchmark's defaults are used, cf. DEFAULT_DELAY and DEFAULT_REPS.
+ */
+struct BenchmarkSettings {
+  size_t numParticipants;
+  size_t delay;
+  size_t reps;
+  bool   hasDelay;
+  bool   hasReps;
+  bool   skipReferenceTime;
+  
+  inline size_t delayOr(const size_t defaultDelay) const { return hasDelay ? delay : defaultDelay; }
+  inline size_t repsOr (const size_t defaultReps)  const { return hasReps  ? reps  : defaultReps;  }
+};
+
+typedef void (*benchmark_routine)(const BenchmarkSettings& settings);
+
+struct BenchmarkEntry {
+  const char*       algorithm;
+  const char*       benchmark;
+  size_t            maxParticipants;  // 0 if not limited
+  benchmark_routine run;
+};
+
+/**
+ * The registry is a function local static, since the registrations run
+ * during the static initialization of the other translation units.
+ */
+inline std::vector<BenchmarkEntry>& benchmark_registry() {
+  static std::vector<BenchmarkEntry> entries;
+  return entries;
+}
+
+inline const BenchmarkEntry* benchmark_find(const char* const algorithm, const char* const benchmark) {
+  const std::vector<BenchmarkEntry>& entries = benchmark_registry();
+  
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (strcmp(entries[i].algorithm, algorithm) == 0 && strcmp(entries[i].benchmark, benchmark) == 0) {
+      return &entries[i];
+    }
+  }
+  return NULL;
+}
+
+class BenchmarkRegistration {
+public:
+  BenchmarkRegistration(const char* const algorithm, const char* const benchmark,
+                        const size_t maxParticipants, const benchmark_routine run) {
+    BenchmarkEntry entry = { algorithm, benchmark, maxParticipants, run };
+    benchmark_registry().push_back(entry);
+  }
+};
+
+#endif
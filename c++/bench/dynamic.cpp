@@ -55,12 +55,22 @@
   #define SKIP_REFERENCE_TIME 1
 #endif
 
+// measure add/drop throughput instead of the barrier performance
+#ifndef MEASURE_REGISTRATIONS
+  #define MEASURE_REGISTRATIONS 0
+#endif
+
 int main (int argc, const char * argv[]) {
   DYNPAR<BARRIER, PARTICIPANT> dynpar(NUM_PARTICIPANTS);
   
-  if (!SKIP_REFERENCE_TIME)
-    dynpar.measureReferenceTime();
-  dynpar.measureBarrierPerformance();
+  if (MEASURE_REGISTRATIONS) {
+    dynpar.measureRegistrationThroughput();
+  }
+  else {
+    if (!SKIP_REFERENCE_TIME)
+      dynpar.measureReferenceTime();
+    dynpar.measureBarrierPerformance();
+  }
   
   pthread_exit(NULL);
   return 0;
@@ -31,8 +31,11 @@ template <class BarrierClass, typename ParticipantType>
 class DYNPAR {
 public:
   
-  DYNPAR(const int numParticipants)
-    : delayLength(500),
+  static const size_t DEFAULT_DELAY = 500;
+  
+  DYNPAR(const int    numParticipants,
+         const size_t delayLength = DEFAULT_DELAY)
+    : delayLength(delayLength),
       numParticipants(numParticipants),
       initalization_finished(false),
       barrier(new BarrierClass(numParticipants))
@@ -42,6 +45,7 @@ public:
   
   void measureReferenceTime();
   void measureBarrierPerformance();
+  void measureRegistrationThroughput();
   
   static void delay(int delayLength);
   
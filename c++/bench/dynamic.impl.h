@@ -35,17 +35,20 @@
 #include <iostream>
 
 #include <pthread.h>
+#include <sched.h>
 
 #ifdef __tile__
 #include <tmc/cpus.h>
 #endif
 
 #include "../misc/get_clock.h"
+#include "../misc/trace.h"
 #include "../misc/misc.h"
 #include "../misc/atomic.h"
 #include "../misc/assert.h"
 
 const size_t OUTERREPS = 1;
+const size_t REGISTRATION_REPS = 1000;
 const double CONF95    = 1.96;
 
 
@@ -54,18 +57,22 @@ double times[OUTERREPS+1], reftime, refsd;
 template <class BarrierClass, typename ParticipantType>
 void DYNPAR<BarrierClass, ParticipantType>::printPreamble() {
 	printf(" Running barrier benchmarks on %zu thread(s)\n", numParticipants);
-	printf("   delayLength: %zu\n", delayLength);
+	printf("   delayLength: %zu%s\n", delayLength, CALIBRATED_DELAY ? " ns" : "");
 }
 
 
 template <class BarrierClass, typename ParticipantType>
 void DYNPAR<BarrierClass, ParticipantType>::delay(int delayLength) {
+#if CALIBRATED_DELAY
+	delay_ns(delayLength);
+#else
 	int   i;
 	float a = 0.0; 
 
 	for (i = 0;  i < delayLength;  i++)  a += i; 
 
 	if  (a < 0) printf("%f \n", a);
+#endif
 } 
 
 
@@ -80,12 +87,12 @@ void DYNPAR<BarrierClass, ParticipantType>::measureReferenceTime() {
 	printf("Computing reference time 1\n"); 
 
 	for (k = 0; k <= OUTERREPS; k++) {
-		start = get_clock(); 
+		start = get_clock_ns(); 
 	
 	  spawnLoopReference();  
 
-		stop = get_clock();
-    times[k] = (stop - start) * 1.0e6;
+		stop = get_clock_ns();
+    times[k] = (stop - start) * 1.0e-3;
 	}
 
 	calculateAndPrintStatistics(&meantime, &sd);
@@ -152,7 +159,8 @@ void* _benchmark(void* threadParam) {
 	BarrierClass* const barrier = dynpar->getBarrier();
   //assert(barrier->phase == param->id - 1);
   
-	ParticipantType* const participant = new ParticipantType(barrier); //this registers the participant on the barrier
+	trace_attach(param->id);
+	ParticipantType* const participant = traced_add<ParticipantType>(barrier); //this registers the participant on the barrier
   //assert(barrier->phase == participant->phase);
   
   memory_fence();
@@ -167,11 +175,11 @@ void* _benchmark(void* threadParam) {
 
 
 		#if USE_TWO_PHASE
-			participant->resume();
+			TRACED(TRACE_RESUME, participant->resume());
 			DYNPAR<BarrierClass, ParticipantType>::delay(dynpar->delayLength);
-			participant->next();
+			TRACED(TRACE_NEXT, participant->next());
 		#else
-			participant->barrier();
+			TRACED(TRACE_BARRIER, participant->barrier());
 			DYNPAR<BarrierClass, ParticipantType>::delay(dynpar->delayLength);
 		#endif
 		
@@ -184,7 +192,38 @@ void* _benchmark(void* threadParam) {
 	//TODO: if we want to run the benchmark more than once to calc std
 	//      this would be the place to remove ourselves as a participant
 	//      OR we can just create a new barrier each time ...
-	participant->drop();
+	TRACED(TRACE_DROP, participant->drop());
+	delete param;
+	pthread_exit(NULL);
+}
+
+template <class BarrierClass, typename ParticipantType>
+void* _benchmarkRegistration(void* threadParam) {
+	ThreadParam* param = (ThreadParam*)threadParam;
+	DYNPAR<BarrierClass, ParticipantType>* dynpar = (DYNPAR<BarrierClass, ParticipantType>*)param->obj;
+
+	// set affinitiy of this thread
+#ifdef __tile__
+	if (tmc_cpus_set_my_cpu(param->cpu_id) != 0) {
+		perror("tmc_cpus_set_my_cpu(..) failed\n");
+		exit(1);
+	}
+#endif
+
+	BarrierClass* const barrier = dynpar->getBarrier();
+
+	trace_attach(param->id);
+	param->initialized = true;
+
+	// all threads start registering at the same time, to get a spawn storm
+	while (!dynpar->initalization_finished) {}
+
+	for (size_t i = 0; i < REGISTRATION_REPS; i++) {
+		ParticipantType* const participant = traced_add<ParticipantType>(barrier);
+		TRACED(TRACE_DROP, participant->drop());
+		delete participant;
+	}
+
 	delete param;
 	pthread_exit(NULL);
 }
@@ -295,11 +334,11 @@ void DYNPAR<BarrierClass, ParticipantType>::spawnLoop(BarrierClass* barrier, Par
 		
 			//Main thread barrier sync
 		#if USE_TWO_PHASE
-			participant->resume();
+			TRACED(TRACE_RESUME, participant->resume());
 			DYNPAR<BarrierClass, ParticipantType>::delay(delayLength);
-			participant->next();
+			TRACED(TRACE_NEXT, participant->next());
 		#else
-			participant->barrier();
+			TRACED(TRACE_BARRIER, participant->barrier());
 			DYNPAR<BarrierClass, ParticipantType>::delay(delayLength);
 		#endif
     
@@ -323,7 +362,8 @@ void DYNPAR<BarrierClass, ParticipantType>::measureBarrierPerformance() {
 	printf("--------------------------------------------------------\n");
 	printf("Computing BARRIER time\n");
 
-
+	trace_prepare(numParticipants);
+	trace_attach(0);
 
 	for (k = 0; k < OUTERREPS; k++){
     #if DEBUG
@@ -334,7 +374,7 @@ void DYNPAR<BarrierClass, ParticipantType>::measureBarrierPerformance() {
 	
 		//stverhae: I put this participant addition inside the timed section
 		//          It was outside before
-		ParticipantType* const participant = new ParticipantType(barrier);
+		ParticipantType* const participant = traced_add<ParticipantType>(barrier);
 
 		spawnLoop(barrier, participant);
 
@@ -348,7 +388,7 @@ void DYNPAR<BarrierClass, ParticipantType>::measureBarrierPerformance() {
 		}
 
 		//TODO
-		participant->drop();
+		TRACED(TRACE_DROP, participant->drop());
 	}
 
 
@@ -360,6 +400,86 @@ void DYNPAR<BarrierClass, ParticipantType>::measureBarrierPerformance() {
 
 }
 
+/**
+ * All threads register and drop participants as fast as possible,
+ * while one participant stays registered, so that the barrier is never empty.
+ */
+template <class BarrierClass, typename ParticipantType>
+void DYNPAR<BarrierClass, ParticipantType>::measureRegistrationThroughput() {
+	uint64_t start, stop;
+
+	printf("\n");
+	printf("--------------------------------------------------------\n");
+	printf("Computing REGISTRATION throughput\n");
+
+#ifdef __tile__
+	cpu_set_t cpus;
+	if (tmc_cpus_get_online_cpus(&cpus)) {
+		perror("tmc_cpus_get_online_cpus failed\n");
+		exit(1);
+	}
+
+	int next_cpu = -1;
+	_find_next_cpu(&cpus, next_cpu);
+
+	if (tmc_cpus_set_my_cpu(next_cpu) != 0) {
+		perror("tmc_cpus_set_my_cpu(..) failed\n");
+		exit(1);
+	}
+#endif
+
+	trace_prepare(numParticipants);
+	trace_attach(0);
+
+	ParticipantType* const anchor = traced_add<ParticipantType>(barrier);
+
+	initalization_finished = false;
+
+	for (size_t i = 1; i < numParticipants; i++) {
+		ThreadParam* param = new ThreadParam();
+		param->obj = (void*)this;
+		param->id  = i;
+#ifdef __tile__
+		param->cpu_id = _find_next_cpu(&cpus, next_cpu);
+#endif
+
+		int rc = pthread_create(&threads[i], NULL,
+				_benchmarkRegistration<BarrierClass, ParticipantType>,
+				(void*)param);
+
+		if (rc) {
+			printf("ERROR; return code from pthread_create() is %d\n", rc);
+			exit(-1);
+		}
+
+		while (!param->initialized) { sched_yield(); }
+	}
+
+	start = get_clock();
+	memory_fence();
+	initalization_finished = true;
+
+	for (size_t i = 0; i < REGISTRATION_REPS; i++) {
+		ParticipantType* const participant = traced_add<ParticipantType>(barrier);
+		TRACED(TRACE_DROP, participant->drop());
+		delete participant;
+	}
+
+	for (size_t i = 1; i < numParticipants; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	stop = get_clock();
+
+	TRACED(TRACE_DROP, anchor->drop());
+
+	const double registrations = (double)numParticipants * REGISTRATION_REPS;
+	const double seconds       = (stop - start) / 1.0e6;
+
+	printf("REGISTRATION time =                      %f microseconds for %.0f add/drop pairs\n", (double)(stop - start), registrations);
+	printf("REGISTRATION throughput =                %f registrations/second\n", registrations / seconds);
+}
+
 template <class BarrierClass, typename ParticipantType>
 void DYNPAR<BarrierClass, ParticipantType>::calculateAndPrintStatistics(double *mtp, double *sdp) {
 
@@ -24,17 +24,26 @@
  * by Mark Bull and Fiona Reid
  */
 
+#include "episodes.h"
+
 typedef void *(*pthread_routine)(void*);
 
 template <class BarrierClass, typename ParticipantType>
 class EPCC {
 public:
   
-  EPCC(const int numParticipants)
-    : delayLength(500),
-      innerReps(10000),
+  static const size_t DEFAULT_DELAY = 500;
+  static const size_t DEFAULT_REPS  = 10000;
+  
+  EPCC(const int    numParticipants,
+       const size_t delayLength = DEFAULT_DELAY,
+       const size_t innerReps   = DEFAULT_REPS)
+    : delayLength(delayLength),
+      innerReps(innerReps),
       numParticipants(numParticipants),
       initalization_finished(false),
+      finishedThreads(0),
+      episodes(NULL),
       barrier(new BarrierClass(numParticipants))
   {
     printPreamble();
@@ -52,6 +61,10 @@ public:
   BarrierClass* getBarrier() { return barrier; }
   
   volatile bool initalization_finished;
+  volatile int  finishedThreads;
+  
+  // only allocated for the barrier measurement
+  EpisodeRecorder* episodes;
   
 private:
   void printPreamble();
@@ -34,12 +34,15 @@
 #include <cmath> 
 
 #include <pthread.h>
+#include <sched.h>
 
 #ifdef __tile__
   #include <tmc/cpus.h>
 #endif
 
 #include "../misc/get_clock.h"
+#include "../misc/stats.h"
+#include "../misc/trace.h"
 #include "../misc/atomic.h"
 #include "../misc/misc.h"
 
@@ -53,19 +56,23 @@ double times[OUTERREPS+1], reftime, refsd;
 template <class BarrierClass, typename ParticipantType>
 void EPCC<BarrierClass, ParticipantType>::printPreamble() {
   printf(" Running barrier benchmarks on %zu thread(s)\n", numParticipants);
-  printf("   delayLength: %zu\n", delayLength);
+  printf("   delayLength: %zu%s\n", delayLength, CALIBRATED_DELAY ? " ns" : "");
   printf("   innerReps: %zu\n",   innerReps);
 }
 
 
 template <class BarrierClass, typename ParticipantType>
 void EPCC<BarrierClass, ParticipantType>::delay(int delayLength) {
+#if CALIBRATED_DELAY
+  delay_ns(delayLength);
+#else
   int   i;
   float a = 0.0; 
   
   for (i = 0;  i < delayLength;  i++)  a += i; 
   
   if  (a < 0) printf("%f \n", a);
+#endif
 } 
 
 
@@ -80,11 +87,11 @@ void EPCC<BarrierClass, ParticipantType>::measureReferenceTime() {
   printf("Computing reference time 1\n"); 
   
   for (k = 0; k <= OUTERREPS; k++) {
-    start = get_clock(); 
+    start = get_clock_ns(); 
     for (j = 0; j < innerReps; j++) {
       delay(delayLength); 
     }
-    times[k] = (get_clock() - start) * 1.0e6 / (double) innerReps;
+    times[k] = (get_clock_ns() - start) * 1.0e-3 / (double) innerReps;
   }
   
   calculateAndPrintStatistics(&meantime, &sd);
@@ -97,16 +104,21 @@ void EPCC<BarrierClass, ParticipantType>::measureReferenceTime() {
 
 
 template <class BarrierClass, typename ParticipantType>
-void innerLoop(EPCC<BarrierClass, ParticipantType>* epcc, BarrierClass* barrier, ParticipantType* const participant) {
+void innerLoop(EPCC<BarrierClass, ParticipantType>* epcc, BarrierClass* barrier, ParticipantType* const participant, const size_t id) {
+  EpisodeRecorder* const episodes = epcc->episodes;
+  
   for (size_t j = 0; j < epcc->innerReps; j++) {
     EPCC<BarrierClass, ParticipantType>::delay(epcc->delayLength);
 #if USE_TWO_PHASE
-    participant->resume();
+    TRACED(TRACE_RESUME, participant->resume());
     EPCC<BarrierClass, ParticipantType>::delay(epcc->delayLength / 2);
-    participant->next();
+    episodes->arrive(id);
+    TRACED(TRACE_NEXT, participant->next());
 #else
-    participant->barrier();
+    episodes->arrive(id);
+    TRACED(TRACE_BARRIER, participant->barrier());
 #endif
+    episodes->depart(id);
   }
 }
 
@@ -140,7 +152,10 @@ void* _benchmark(void* threadParam) {
   
   BarrierClass* const barrier = epcc->getBarrier();
   
-  ParticipantType* const participant = new ParticipantType(barrier); //this registers the participant on the barrier
+  trace_attach(param->id);
+  stats_attach(param->id);
+  ParticipantType* const participant = traced_add<ParticipantType>(barrier); //this registers the participant on the barrier
+  const size_t id = param->id;
   
   memory_fence();  // make sure everything is done
   
@@ -152,17 +167,20 @@ void* _benchmark(void* threadParam) {
   
   size_t k;
   for (k = 0; k <= OUTERREPS; k++){
-    innerLoop(epcc, barrier, participant);
+    innerLoop(epcc, barrier, participant, id);
     
 #if USE_TWO_PHASE
-    participant->resume();
+    TRACED(TRACE_RESUME, participant->resume());
     EPCC<BarrierClass, ParticipantType>::delay(epcc->delayLength / 2);
-    participant->next();
+    TRACED(TRACE_NEXT, participant->next());
 #else
-    participant->barrier();
+    TRACED(TRACE_BARRIER, participant->barrier());
 #endif
   }
   
+  // lets the main thread know, that this thread did its last wait
+  atomic_add_and_fetch((int*)&epcc->finishedThreads, 1);
+  
   delete param;
   pthread_exit(NULL);
 }
@@ -238,23 +256,28 @@ void EPCC<BarrierClass, ParticipantType>::measureBarrierPerformance() {
   printf("Computing BARRIER time\n");
   
   
-  ParticipantType* const participant = new ParticipantType(barrier);
+  trace_prepare(numParticipants);
+  trace_attach(0);
+  stats_attach(0);
+  ParticipantType* const participant = traced_add<ParticipantType>(barrier);
 
+  // the first outer repetition is only the warmup
+  episodes = new EpisodeRecorder(numParticipants, (OUTERREPS + 1) * innerReps);
   
   spawnThreads();
 
   for (k = 0; k <= OUTERREPS; k++){
-    start  = get_clock(); 
+    start  = get_clock_ns(); 
     
-    innerLoop(this, barrier, participant);
+    innerLoop(this, barrier, participant, 0);
     
-    times[k] = (get_clock() - start) * 1.0e6 / (double) innerReps;
+    times[k] = (get_clock_ns() - start) * 1.0e-3 / (double) innerReps;
 #if USE_TWO_PHASE
-    participant->resume();
+    TRACED(TRACE_RESUME, participant->resume());
     EPCC<BarrierClass, ParticipantType>::delay(delayLength / 2);
-    participant->next();
+    TRACED(TRACE_NEXT, participant->next());
 #else
-    participant->barrier();
+    TRACED(TRACE_BARRIER, participant->barrier());
 #endif
   }
   
@@ -265,6 +288,11 @@ void EPCC<BarrierClass, ParticipantType>::measureBarrierPerformance() {
   
   printf("BARRIER overhead =                       %f microseconds +/- %f\n", meantime-reftime, CONF95*(sd+refsd));
   
+  // the counters are only complete after all threads did their last wait
+  while (finishedThreads != (int)numParticipants - 1) { sched_yield(); }
+  
+  episodes->report(innerReps);
+  stats_report();
 }
 
 template <class BarrierClass, typename ParticipantType>
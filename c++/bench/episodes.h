@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  Records per-episode arrival and departure timestamps of every thread of
+ *  a benchmark, and reports the distribution of the barrier latencies:
+ *    release       last arrival to last departure
+ *    arrival skew  first arrival to last arrival
+ *    episode       first arrival to last departure
+ *  A thread arrives when it starts to wait, i.e., calls next() or barrier(),
+ *  and departs when that call returns. Timestamps are taken with
+ *  get_cycles(), which assumes the cycle counters of all cores to be
+ *  synchronized.
+ *
+ *  Recording is only compiled in with EPISODE_STATS, otherwise the hooks
+ *  are empty and the benchmarks are timed as before.
+ */
+
+#ifndef __EPISODES_H__
+#define __EPISODES_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdio>
+#include <sched.h>
+
+#include "../misc/atomic.h"
+#include "../misc/align.h"
+#include "../misc/get_clock.h"
+#include "../misc/histogram.h"
+
+#ifndef EPISODE_STATS
+  #define EPISODE_STATS false
+#endif
+
+class EpisodeRecorder {
+public:
+  
+  /**
+   * Every thread records at most numEpisodes episodes, all buffers are
+   * allocated upfront to keep the allocator out of the measurement.
+   */
+  EpisodeRecorder(const size_t numThreads, const size_t numEpisodes)
+    : numThreads(numThreads),
+      numEpisodes(numEpisodes),
+      buffers(EPISODE_STATS ? new CacheLinePadded<Buffer>[numThreads] : NULL)
+  {
+    if (!EPISODE_STATS) {
+      return;
+    }
+    
+    for (size_t i = 0; i < numThreads; i++) {
+      Buffer& buffer    = buffers[i].value;
+      buffer.arrivals   = new uint64_t[numEpisodes];
+      buffer.departures = new uint64_t[numEpisodes];
+      buffer.recorded   = 0;
+      
+      // touch the buffers, so that page faults do not hit the measurement
+      for (size_t j = 0; j < numEpisodes; j++) {
+        buffer.arrivals[j]   = 0;
+        buffer.departures[j] = 0;
+      }
+    }
+  }
+  
+  ~EpisodeRecorder() {
+    if (!EPISODE_STATS) {
+      return;
+    }
+    
+    for (size_t i = 0; i < numThreads; i++) {
+      delete[] buffers[i].value.arrivals;
+      delete[] buffers[i].value.departures;
+    }
+    delete[] buffers;
+  }
+  
+  inline void arrive(const size_t thread) {
+    if (!EPISODE_STATS) {
+      return;
+    }
+    
+    Buffer& buffer = buffers[thread].value;
+    if (buffer.recorded < numEpisodes) {
+      buffer.arrivals[buffer.recorded] = get_cycles();
+    }
+  }
+  
+  inline void depart(const size_t thread) {
+    if (!EPISODE_STATS) {
+      return;
+    }
+    
+    Buffer& buffer = buffers[thread].value;
+    if (buffer.recorded < numEpisodes) {
+      buffer.departures[buffer.recorded] = get_cycles();
+      atomic_store<ORDER_RELEASE>(&buffer.recorded, buffer.recorded + 1);
+    }
+  }
+  
+  /**
+   * Waits until all threads have recorded all episodes, and prints the
+   * histograms of all episodes after the first warmupEpisodes.
+   */
+  void report(const size_t warmupEpisodes) {
+    if (!EPISODE_STATS) {
+      return;
+    }
+    
+    for (size_t i = 0; i < numThreads; i++) {
+      while (atomic_load<ORDER_ACQUIRE>(&buffers[i].value.recorded) < numEpisodes) {
+        sched_yield();
+      }
+    }
+    
+    LatencyHistogram release, skew, episode;
+    
+    for (size_t j = warmupEpisodes; j < numEpisodes; j++) {
+      uint64_t firstArrival  = buffers[0].value.arrivals[j];
+      uint64_t lastArrival   = firstArrival;
+      uint64_t lastDeparture = buffers[0].value.departures[j];
+      
+      for (size_t i = 1; i < numThreads; i++) {
+        const Buffer& buffer = buffers[i].value;
+        
+        if (buffer.arrivals[j]   < firstArrival)  firstArrival  = buffer.arrivals[j];
+        if (buffer.arrivals[j]   > lastArrival)   lastArrival   = buffer.arrivals[j];
+        if (buffer.departures[j] > lastDeparture) lastDeparture = buffer.departures[j];
+      }
+      
+      // a thread can only depart after all arrived, unless the counters drift
+      if (lastDeparture < lastArrival) {
+        lastDeparture = lastArrival;
+      }
+      
+      release.record(cycles_to_ns(lastDeparture - lastArrival));
+      skew.record   (cycles_to_ns(lastArrival   - firstArrival));
+      episode.record(cycles_to_ns(lastDeparture - firstArrival));
+    }
+    
+    printf("\n");
+    printf("--------------------------------------------------------\n");
+    printf("Episode latencies in nanoseconds, %zu episodes\n", release.getCount());
+    printf("\n");
+    printf("%-12s %10s %10s %10s %10s %10s %10s %10s\n", "",
+           "Min", "p50", "p90", "p99", "p99.9", "Max", "Mean");
+    printHistogram("release",      release);
+    printHistogram("arrival skew", skew);
+    printHistogram("episode",      episode);
+    printf("\n");
+  }
+  
+private:
+  struct Buffer {
+    uint64_t*       arrivals;
+    uint64_t*       departures;
+    volatile size_t recorded;
+  };
+  
+  static void printHistogram(const char* const name, const LatencyHistogram& histogram) {
+    printf("%-12s %10llu %10llu %10llu %10llu %10llu %10llu %10.1f\n", name,
+           (unsigned long long)histogram.getMin(),
+           (unsigned long long)histogram.percentile(50.0),
+           (unsigned long long)histogram.percentile(90.0),
+           (unsigned long long)histogram.percentile(99.0),
+           (unsigned long long)histogram.percentile(99.9),
+           (unsigned long long)histogram.getMax(),
+           histogram.getMean());
+  }
+  
+  const size_t numThreads;
+  const size_t numEpisodes;
+  
+  CacheLinePadded<Buffer>* const buffers;
+};
+
+#endif
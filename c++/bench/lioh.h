@@ -21,19 +21,28 @@
  * THE SOFTWARE.
  */
 
+#include "episodes.h"
+
 typedef void *(*pthread_routine)(void*);
 
 template <class BarrierClass, typename ParticipantType>
 class LIOH {
 public:
   
-  LIOH(const int numParticipants)
-    : outerDelay(100000), //100ms
+  static const size_t DEFAULT_DELAY = 100000; //100ms
+  static const size_t DEFAULT_REPS  = 100;
+  
+  LIOH(const int    numParticipants,
+       const size_t outerDelay = DEFAULT_DELAY,
+       const size_t innerReps  = DEFAULT_REPS)
+    : outerDelay(outerDelay),
 			delayI(10000), //10ms
 			delayS(500),  //0.5ms
-      innerReps(100),
+      innerReps(innerReps),
       numParticipants(numParticipants),
       initalization_finished(false),
+      finishedThreads(0),
+      episodes(NULL),
       barrier(new BarrierClass(numParticipants))
   {
     printPreamble();
@@ -54,6 +63,10 @@ public:
   BarrierClass* getBarrier() { return barrier; }
   
   volatile bool initalization_finished;
+  volatile int  finishedThreads;
+  
+  // only allocated for the barrier measurement
+  EpisodeRecorder* episodes;
   
 private:
   void printPreamble();
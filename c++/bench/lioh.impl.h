@@ -41,6 +41,8 @@
 #endif
 
 #include "../misc/get_clock.h"
+#include "../misc/stats.h"
+#include "../misc/trace.h"
 #include "../misc/atomic.h"
 #include "../misc/misc.h"
 
@@ -64,25 +66,21 @@ void LIOH<BarrierClass, ParticipantType>::printPreamble() {
 
 template <class BarrierClass, typename ParticipantType>
 void LIOH<BarrierClass, ParticipantType>::delay(int delayLength) {
+#if CALIBRATED_DELAY
+  delay_ns(delayLength);
+#else
   int   i;
   float a = 0.0; 
   
   for (i = 0;  i < delayLength;  i++)  a += i; 
   
   if  (a < 0) printf("%f \n", a);
+#endif
 } 
 
 template <class BarrierClass, typename ParticipantType>
 void LIOH<BarrierClass, ParticipantType>::delayTime(unsigned int delta) {
-	uint64_t start;
-	uint64_t current;
-    
-	start = get_clock(); 
-
-	do{
-		current = get_clock();
-	} while(current - start < delta);
-
+	delay_ns((uint64_t)delta * 1000);
 }
 
 template <class BarrierClass, typename ParticipantType>
@@ -116,7 +114,9 @@ void LIOH<BarrierClass, ParticipantType>::measureReferenceTime() {
 
 
 template <class BarrierClass, typename ParticipantType>
-void innerLoop(LIOH<BarrierClass, ParticipantType>* lioh, BarrierClass* barrier, ParticipantType* const participant, bool slow) {
+void innerLoop(LIOH<BarrierClass, ParticipantType>* lioh, BarrierClass* barrier, ParticipantType* const participant, bool slow, const size_t id) {
+  EpisodeRecorder* const episodes = lioh->episodes;
+  
   for (size_t j = 0; j < lioh->innerReps; j++) {
 		if(DEBUG) printf("thread> Starting innerloop %zu\n", j);
 		if(slow)
@@ -125,11 +125,14 @@ void innerLoop(LIOH<BarrierClass, ParticipantType>* lioh, BarrierClass* barrier,
 			LIOH<BarrierClass, ParticipantType>::delayTime(lioh->delayS);
 
 #if USE_TWO_PHASE
-    participant->resume();
-    participant->next();
+    TRACED(TRACE_RESUME, participant->resume());
+    episodes->arrive(id);
+    TRACED(TRACE_NEXT, participant->next());
 #else
-    participant->barrier();
+    episodes->arrive(id);
+    TRACED(TRACE_BARRIER, participant->barrier());
 #endif
+    episodes->depart(id);
   }
 }
 
@@ -163,7 +166,10 @@ void* _benchmark(void* threadParam) {
   
   BarrierClass* const barrier = lioh->getBarrier();
   
-  ParticipantType* const participant = new ParticipantType(barrier); //this registers the participant on the barrier
+  trace_attach(param->id);
+  stats_attach(param->id);
+  ParticipantType* const participant = traced_add<ParticipantType>(barrier); //this registers the participant on the barrier
+  const size_t id = param->id;
   
   memory_fence();  // make sure everything is done
   
@@ -176,12 +182,15 @@ void* _benchmark(void* threadParam) {
   size_t k;
   for (k = 0; k <= OUTERREPS; k++){
 		if(DEBUG) printf("thread> Starting outerloop %zu\n", k);
-    innerLoop(lioh, barrier, participant, false);
+    innerLoop(lioh, barrier, participant, false, id);
 		if(DEBUG) printf("thread> Ended outerloop %zu\n", k);
     
     LIOH<BarrierClass, ParticipantType>::delayTime(lioh->outerDelay);
   }
   
+  // lets the main thread know, that this thread did its last wait
+  atomic_add_and_fetch((int*)&lioh->finishedThreads, 1);
+  
   delete param;
   pthread_exit(NULL);
 }
@@ -257,8 +266,13 @@ void LIOH<BarrierClass, ParticipantType>::measureBarrierPerformance() {
   printf("Computing BARRIER time\n");
   
   
-  ParticipantType* const participant = new ParticipantType(barrier);
+  trace_prepare(numParticipants);
+  trace_attach(0);
+  stats_attach(0);
+  ParticipantType* const participant = traced_add<ParticipantType>(barrier);
 
+  // the first outer repetition is only the warmup
+  episodes = new EpisodeRecorder(numParticipants, (OUTERREPS + 1) * innerReps);
   
   spawnThreads();
 
@@ -266,7 +280,7 @@ void LIOH<BarrierClass, ParticipantType>::measureBarrierPerformance() {
     start  = get_clock(); 
 		if(DEBUG) printf("main> Starting outerloop %zu\n", k);
     
-    innerLoop(this, barrier, participant, true);
+    innerLoop(this, barrier, participant, true, 0);
 
 		if(DEBUG) printf("main> Stopping outerloop %zu\n", k);
    
@@ -284,6 +298,11 @@ void LIOH<BarrierClass, ParticipantType>::measureBarrierPerformance() {
   
   printf("BARRIER overhead =                       %f microseconds +/- %f\n", meantime-reftime, CONF95*(sd+refsd));
   
+  // the counters are only complete after all threads did their last wait
+  while (finishedThreads != (int)numParticipants - 1) { sched_yield(); }
+  
+  episodes->report(innerReps);
+  stats_report();
 }
 
 template <class BarrierClass, typename ParticipantType>
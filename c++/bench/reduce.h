@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2010 Stijn Verhaegen, Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The REDUCE benchmark is the EPCC barrier benchmark with an accumulator:
+ * in episode e, every participant contributes its id + e on resume(), and
+ * every episode checks that next() returns the sum, the minimum, or the
+ * maximum of these values. Thus, it measures the reduction folded into the
+ * barrier, and verifies it at the same time. Each operation is measured
+ * on int64 values, and on doubles, which are offset by 0.5 to keep them
+ * apart from integers, but still exact. Only barriers with SyncTree
+ * accumulators are supported, cf. ACCUMULATOR_BARRIERS in barrier.mk.
+ */
+
+typedef void *(*pthread_routine)(void*);
+
+struct ReduceCase {
+  SyncTree::AccumulatorOperation operation;
+  SyncTree::AccumulatorType      type;
+  const char*                    name;
+};
+
+static const ReduceCase REDUCE_CASES[] = {
+  { SyncTree::ACC_SUM, SyncTree::ACC_INT64,  "sum int64"  },
+  { SyncTree::ACC_MIN, SyncTree::ACC_INT64,  "min int64"  },
+  { SyncTree::ACC_MAX, SyncTree::ACC_INT64,  "max int64"  },
+  { SyncTree::ACC_SUM, SyncTree::ACC_DOUBLE, "sum double" },
+  { SyncTree::ACC_MIN, SyncTree::ACC_DOUBLE, "min double" },
+  { SyncTree::ACC_MAX, SyncTree::ACC_DOUBLE, "max double" }
+};
+
+#define NUM_REDUCE_CASES (sizeof(REDUCE_CASES) / sizeof(REDUCE_CASES[0]))
+
+template <class BarrierClass, typename ParticipantType>
+class REDUCE {
+public:
+  
+  static const size_t DEFAULT_DELAY = 500;
+  static const size_t DEFAULT_REPS  = 10000;
+  
+  REDUCE(const int    numParticipants,
+         const size_t delayLength = DEFAULT_DELAY,
+         const size_t innerReps   = DEFAULT_REPS)
+    : delayLength(delayLength),
+      innerReps(innerReps),
+      numParticipants(numParticipants),
+      initalization_finished(false),
+      finishedThreads(0),
+      errors(0)
+  {
+    for (size_t c = 0; c < NUM_REDUCE_CASES; c++) {
+      barriers[c] = new BarrierClass(numParticipants, REDUCE_CASES[c].operation, REDUCE_CASES[c].type);
+    }
+    
+    printPreamble();
+  }
+  
+  void measureReferenceTime();
+  void measureBarrierPerformance();
+  
+  static void delay(int delayLength);
+  
+  /**
+   * One episode of the given case, contributing id + episode.
+   * Counts an error if the result is not the one expected for all ids.
+   */
+  inline void reduce(const size_t c, ParticipantType* const participant,
+                     const size_t id, const size_t episode);
+  
+  inline bool isExpected(const size_t c, const SyncTree::AccumulatorValue result,
+                         const size_t episode) const;
+  
+  const size_t  delayLength;
+  const size_t  innerReps;
+  const size_t  numParticipants;
+  
+  BarrierClass* getBarrier(const size_t c) { return barriers[c]; }
+  
+  volatile bool initalization_finished;
+  volatile int  finishedThreads;
+  volatile int  errors;
+  
+private:
+  void printPreamble();
+  void calculateAndPrintStatistics(double *mtp, double *sdp);
+  
+  void spawnThreads();
+  
+  BarrierClass* barriers[NUM_REDUCE_CASES];
+};
+
+// we need the implementation in the header
+#include "reduce.impl.h"
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2010 Stijn Verhaegen, Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath> 
+
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef __tile__
+  #include <tmc/cpus.h>
+#endif
+
+#include "../misc/get_clock.h"
+#include "../misc/stats.h"
+#include "../misc/trace.h"
+#include "../misc/atomic.h"
+#include "../misc/misc.h"
+
+
+const size_t OUTERREPS = 1;
+const double CONF95    = 1.96;
+
+
+double times[OUTERREPS+1], reftime, refsd; 
+
+template <class BarrierClass, typename ParticipantType>
+void REDUCE<BarrierClass, ParticipantType>::printPreamble() {
+  printf(" Running reduction benchmarks on %zu thread(s)\n", numParticipants);
+  printf("   delayLength: %zu%s\n", delayLength, CALIBRATED_DELAY ? " ns" : "");
+  printf("   innerReps: %zu\n",   innerReps);
+  printf("   cases: %zu\n", (size_t)NUM_REDUCE_CASES);
+}
+
+
+template <class BarrierClass, typename ParticipantType>
+void REDUCE<BarrierClass, ParticipantType>::delay(int delayLength) {
+#if CALIBRATED_DELAY
+  delay_ns(delayLength);
+#else
+  int   i;
+  float a = 0.0; 
+  
+  for (i = 0;  i < delayLength;  i++)  a += i; 
+  
+  if  (a < 0) printf("%f \n", a);
+#endif
+} 
+
+
+template <class BarrierClass, typename ParticipantType>
+void REDUCE<BarrierClass, ParticipantType>::measureReferenceTime() {
+  size_t j, k;
+  uint64_t start;
+  double meantime, sd;
+  
+  printf("\n");
+  printf("--------------------------------------------------------\n");
+  printf("Computing reference time 1\n"); 
+  
+  for (k = 0; k <= OUTERREPS; k++) {
+    start = get_clock_ns(); 
+    for (j = 0; j < innerReps; j++) {
+      delay(delayLength); 
+    }
+    times[k] = (get_clock_ns() - start) * 1.0e-3 / (double) innerReps;
+  }
+  
+  calculateAndPrintStatistics(&meantime, &sd);
+  
+  printf("Reference_time_1 =                        %f microseconds +/- %f\n", meantime, CONF95*sd);
+  
+  reftime = meantime;
+  refsd = sd;  
+}
+
+
+template <class BarrierClass, typename ParticipantType>
+inline void REDUCE<BarrierClass, ParticipantType>::reduce(const size_t c, ParticipantType* const participant,
+                                                          const size_t id, const size_t episode) {
+  SyncTree::AccumulatorValue result;
+  
+  if (REDUCE_CASES[c].type == SyncTree::ACC_INT64) {
+    TRACED(TRACE_RESUME, participant->resume((int64_t)(id + episode)));
+  }
+  else {
+    TRACED(TRACE_RESUME, participant->resume((double)(id + episode) + 0.5));
+  }
+  TRACED(TRACE_NEXT, result = participant->next());
+  
+  if (!isExpected(c, result, episode)) {
+    atomic_add_and_fetch((int*)&errors, 1);
+  }
+}
+
+
+template <class BarrierClass, typename ParticipantType>
+inline bool REDUCE<BarrierClass, ParticipantType>::isExpected(const size_t c, const SyncTree::AccumulatorValue result,
+                                                              const size_t episode) const {
+  const int64_t n = (int64_t)numParticipants;
+  const int64_t e = (int64_t)episode;
+  
+  int64_t expected;
+  switch (REDUCE_CASES[c].operation) {
+    case SyncTree::ACC_MIN: expected = e;                       break;
+    case SyncTree::ACC_MAX: expected = n - 1 + e;               break;
+    default:                expected = n * (n - 1) / 2 + n * e; break;
+  }
+  
+  if (REDUCE_CASES[c].type == SyncTree::ACC_INT64) {
+    return result.asInt64 == expected;
+  }
+  
+  // all values are multiples of 0.5, thus, the result is exact in any order
+  const double offset = (REDUCE_CASES[c].operation == SyncTree::ACC_SUM) ? 0.5 * n : 0.5;
+  return result.asDouble == (double)expected + offset;
+}
+
+
+template <class BarrierClass, typename ParticipantType>
+void innerLoop(REDUCE<BarrierClass, ParticipantType>* reduce, const size_t c, ParticipantType* const participant,
+               const size_t id, size_t& episode) {
+  for (size_t j = 0; j < reduce->innerReps; j++) {
+    REDUCE<BarrierClass, ParticipantType>::delay(reduce->delayLength);
+    reduce->reduce(c, participant, id, episode);
+    episode++;
+  }
+}
+
+
+class ThreadParam {
+public:
+  ThreadParam() : obj(NULL), id(0), initialized(false) {}
+           void*  obj;
+           size_t id;
+  volatile bool   initialized;
+  
+#ifdef __tile__
+           int    cpu_id;
+#endif
+};
+
+
+template <class BarrierClass, typename ParticipantType>
+void* _benchmark(void* threadParam) {
+  ThreadParam* param = (ThreadParam*)threadParam;
+  REDUCE<BarrierClass, ParticipantType>* reduce = (REDUCE<BarrierClass, ParticipantType>*)param->obj;
+  
+  // set affinitiy of this thread
+#ifdef __tile__
+  if (tmc_cpus_set_my_cpu(param->cpu_id) != 0) {
+    perror("tmc_cpus_set_my_cpu(..) failed\n");
+    exit(1);
+  }
+#endif
+  
+  trace_attach(param->id);
+  stats_attach(param->id);
+  
+  //this registers the participant on the barrier of every case
+  ParticipantType* participants[NUM_REDUCE_CASES];
+  for (size_t c = 0; c < NUM_REDUCE_CASES; c++) {
+    participants[c] = traced_add<ParticipantType>(reduce->getBarrier(c));
+  }
+  const size_t id = param->id;
+  
+  memory_fence();  // make sure everything is done
+  
+  // signal that this thread has registered with the barrier
+  param->initialized = true;
+  
+  // synchronize all participants before the actual benchmark
+  while (!reduce->initalization_finished) { sched_yield(); }
+  
+  for (size_t c = 0; c < NUM_REDUCE_CASES; c++) {
+    size_t episode = 0;
+    size_t k;
+    for (k = 0; k <= OUTERREPS; k++){
+      innerLoop(reduce, c, participants[c], id, episode);
+      reduce->reduce(c, participants[c], id, episode);
+      episode++;
+    }
+  }
+  
+  // lets the main thread know, that all results were checked
+  atomic_add_and_fetch((int*)&reduce->finishedThreads, 1);
+  
+  delete param;
+  pthread_exit(NULL);
+}
+
+#ifdef __tile__
+int _find_next_cpu(cpu_set_t* cpus, int& next_cpu) {
+  next_cpu++;
+  while (next_cpu < TMC_CPUS_MAX_COUNT && !tmc_cpus_has_cpu(cpus, next_cpu)) {
+    next_cpu++;
+  }
+  return next_cpu;
+}
+#endif
+
+template <class BarrierClass, typename ParticipantType>
+void REDUCE<BarrierClass, ParticipantType>::spawnThreads() {
+  pthread_t threads[numParticipants];   // thread handles
+
+  // on the tilera we can set the thread affinity, but we need some infos for that
+#ifdef __tile__
+  cpu_set_t cpus;
+  if (tmc_cpus_get_online_cpus(&cpus)) {
+    perror("tmc_cpus_get_online_cpus failed\n");
+    exit(1);
+  }
+  
+  int next_cpu = -1;  // to make sure the first found cpu has id 0
+  _find_next_cpu(&cpus, next_cpu);  //should be 0 or something else if that tile is not available to linux
+  
+  if (tmc_cpus_set_my_cpu(next_cpu) != 0) {
+    perror("tmc_cpus_set_my_cpu(..) failed\n");
+    exit(1);
+  }
+#endif
+  
+  for (size_t i = 1; i < numParticipants; i++) {
+    ThreadParam* param = new ThreadParam();
+    param->obj = (void*)this;
+    param->id  = i;
+#ifdef __tile__
+    // find a cpu and give it to the new thread
+    param->cpu_id = _find_next_cpu(&cpus, next_cpu);
+#endif
+    
+    int rc = pthread_create(&threads[i], NULL, 
+                            _benchmark<BarrierClass, ParticipantType>,
+                            (void*)param);
+    
+    if (rc){
+      printf("ERROR; return code from pthread_create() is %d\n", rc);
+      exit(-1);
+    }
+    
+    // make sure the spawned thread registerd on the barrier
+    while (!param->initialized) { sched_yield(); }
+  }
+  
+  for (size_t c = 0; c < NUM_REDUCE_CASES; c++) {
+    barriers[c]->finalize_initialization();
+  }
+  memory_fence();
+  initalization_finished = true;
+}
+
+template <class BarrierClass, typename ParticipantType>
+void REDUCE<BarrierClass, ParticipantType>::measureBarrierPerformance() {
+  size_t k; 
+  uint64_t start; 
+  double meantime[NUM_REDUCE_CASES], sd[NUM_REDUCE_CASES];
+  
+  printf("\n");
+  printf("--------------------------------------------------------\n");
+  printf("Computing REDUCTION time\n");
+  
+  trace_prepare(numParticipants);
+  trace_attach(0);
+  stats_attach(0);
+  ParticipantType* participants[NUM_REDUCE_CASES];
+  for (size_t c = 0; c < NUM_REDUCE_CASES; c++) {
+    participants[c] = traced_add<ParticipantType>(barriers[c]);
+  }
+  
+  spawnThreads();
+  
+  for (size_t c = 0; c < NUM_REDUCE_CASES; c++) {
+    size_t episode = 0;
+    for (k = 0; k <= OUTERREPS; k++){
+      start  = get_clock_ns(); 
+      
+      innerLoop(this, c, participants[c], 0, episode);
+      
+      times[k] = (get_clock_ns() - start) * 1.0e-3 / (double) innerReps;
+      reduce(c, participants[c], 0, episode);
+      episode++;
+    }
+    
+    calculateAndPrintStatistics(&meantime[c], &sd[c]);
+  }
+  
+  // after this, all threads checked their results, and did their last wait
+  while (finishedThreads != (int)numParticipants - 1) { sched_yield(); }
+  
+  
+  for (size_t c = 0; c < NUM_REDUCE_CASES; c++) {
+    printf("REDUCTION %-10s time =              %f microseconds +/- %f\n",
+           REDUCE_CASES[c].name, meantime[c], CONF95*sd[c]);
+    
+    printf("REDUCTION %-10s overhead =          %f microseconds +/- %f\n",
+           REDUCE_CASES[c].name, meantime[c]-reftime, CONF95*(sd[c]+refsd));
+  }
+  
+  printf("REDUCTION errors =                       %d\n", errors);
+  
+  stats_report();
+  
+  if (errors != 0) {
+    fprintf(stderr, "%d of the reductions did not return the expected result\n", errors);
+    exit(1);
+  }
+}
+
+template <class BarrierClass, typename ParticipantType>
+void REDUCE<BarrierClass, ParticipantType>::calculateAndPrintStatistics(double *mtp, double *sdp) {
+  
+  double meantime, totaltime, sumsq, mintime, maxtime, sd, cutoff; 
+  
+  size_t i, nr; 
+  
+  mintime = 1.0e10;
+  maxtime = 0.;
+  totaltime = 0.;
+  
+  for (i = 1; i <= OUTERREPS; i++){
+    mintime = (mintime < times[i]) ? mintime : times[i];
+    maxtime = (maxtime > times[i]) ? maxtime : times[i];
+    totaltime +=times[i]; 
+  } 
+  
+  meantime  = totaltime / OUTERREPS;
+  sumsq = 0; 
+  
+  for (i = 1; i <= OUTERREPS; i++){
+    sumsq += (times[i]-meantime)* (times[i]-meantime); 
+  }
+
+#if OUTERREPS > 1
+    sd = sqrt(sumsq/(OUTERREPS-1));
+#else
+    sd = 0;
+#endif
+
+  
+  cutoff = 3.0 * sd; 
+  
+  nr = 0; 
+  
+  for (i=1; i <= OUTERREPS; i++){
+    if ( fabs(times[i]-meantime) > cutoff ) nr ++; 
+  }
+  
+  printf("\n"); 
+  printf("Sample_size       Average     Min         Max          S.D.          Outliers\n");
+  printf(" %zu                %f   %f   %f    %f      %zu\n",OUTERREPS, meantime, mintime, maxtime, sd, nr); 
+  printf("\n");
+  
+  *mtp = meantime; 
+  *sdp = sd; 
+  
+} 
+
+
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  This header file defines cache line padding and aligned allocation for
+ *  the shared state of the barriers.
+ *
+ *  The padded layout is the default. Compile with -DUSE_PADDING=0 to get the
+ *  compact layout, e.g., to measure the effect of false sharing.
+ */
+
+#ifndef __ALIGN_H__
+#define __ALIGN_H__
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef __TILECC__
+  #include <malloc.h>
+#endif
+
+#include "misc.h"
+
+#ifndef USE_PADDING
+  #define USE_PADDING 1
+#endif
+
+/**
+ * Declares a member of the size of a cache line, which separates the members
+ * declared before it from the ones declared after it.
+ * Without padding, it declares a type instead, which does not take any space.
+ */
+#if USE_PADDING
+  #define CACHE_LINE_PAD(name) char name[CACHE_LINE_SIZE]
+#else
+  #define CACHE_LINE_PAD(name) typedef char name
+#endif
+
+/**
+ * Allocates memory starting at a cache line boundary,
+ * has to be released with cache_aligned_free().
+ */
+inline void* cache_aligned_malloc(const size_t size) {
+#if !USE_PADDING
+  return malloc(size);
+#elif defined(__TILECC__)
+  return memalign(CACHE_LINE_SIZE, size);
+#else
+  void* result = NULL;
+  if (posix_memalign(&result, CACHE_LINE_SIZE, size) != 0) {
+    return NULL;
+  }
+  return result;
+#endif
+}
+
+inline void cache_aligned_free(void* const ptr) {
+  free(ptr);
+}
+
+/**
+ * Objects of classes deriving from CacheLineAligned start at a cache line
+ * boundary when they are allocated with new.
+ * Like the global new, it throws std::bad_alloc when it runs out of memory.
+ */
+class CacheLineAligned {
+public:
+  static void* operator new(const size_t size)   { return allocate(size); }
+  static void* operator new[](const size_t size) { return allocate(size); }
+  
+  static void operator delete(void* const ptr)   { cache_aligned_free(ptr); }
+  static void operator delete[](void* const ptr) { cache_aligned_free(ptr); }
+  
+private:
+  static void* allocate(const size_t size) {
+    void* const result = cache_aligned_malloc(size);
+    if (result == NULL) {
+      throw std::bad_alloc();
+    }
+    return result;
+  }
+};
+
+/**
+ * A value which does not share its cache line with any other value,
+ * as long as the array or object containing it is cache line aligned.
+ */
+template<typename T>
+struct CacheLinePadded : public CacheLineAligned {
+  T value;
+#if USE_PADDING
+  char padding[CACHE_LINE_SIZE - sizeof(T) % CACHE_LINE_SIZE];
+#endif
+};
+
+#endif
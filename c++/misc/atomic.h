@@ -25,6 +25,7 @@
  */
 
 #include "misc.h"
+#include <stdint.h>
 
 # ifdef __TILECC__
   # include <atomic.h>
@@ -57,6 +58,18 @@ inline int atomic_compare_and_swap(int* ptr, int oldValue, int newValue) {
 # endif
 }
 
+/**
+ * 64-bit variant, also on 32-bit platforms
+ * @return the old value of *ptr
+ */
+inline int64_t atomic_compare_and_swap(int64_t* ptr, int64_t oldValue, int64_t newValue) {
+# ifdef __TILECC__
+  return atomic_compare_and_exchange_val_acq(ptr, newValue, oldValue);
+# else
+  return __sync_val_compare_and_swap(ptr, oldValue, newValue);
+# endif
+}
+
 /**
  * @return true if CAS was sucessful
  */
@@ -77,4 +90,137 @@ inline void memory_fence() {
 # endif
 }
 
+
+/**
+ * Typed atomics with explicit memory orders
+ *
+ * The functions above are all full barriers on int. The templates below
+ * work on 32-bit and 64-bit integers, pointers, and for loads and stores
+ * also on bool, and take the required ordering as template argument:
+ *
+ *    atomic_store<ORDER_RELEASE>(&flag, sense);
+ *    while (atomic_load<ORDER_ACQUIRE>(&flag) != sense) ;
+ *
+ * With GCC's __atomic builtins the orders are passed through, otherwise
+ * (tile-cc) loads and stores are fenced as needed, and read-modify-write
+ * operations fall back to the __sync builtins, which are full barriers.
+ */
+enum MemoryOrder {
+# ifdef __ATOMIC_RELAXED
+  ORDER_RELAXED = __ATOMIC_RELAXED,
+  ORDER_ACQUIRE = __ATOMIC_ACQUIRE,
+  ORDER_RELEASE = __ATOMIC_RELEASE,
+  ORDER_ACQ_REL = __ATOMIC_ACQ_REL,
+  ORDER_SEQ_CST = __ATOMIC_SEQ_CST
+# else
+  ORDER_RELAXED,
+  ORDER_ACQUIRE,
+  ORDER_RELEASE,
+  ORDER_ACQ_REL,
+  ORDER_SEQ_CST
+# endif
+};
+
+# if !defined(__ATOMIC_RELAXED) || defined(__TILECC__)
+  #define ATOMIC_USE_SYNC_BUILTINS 1
+# endif
+
+template<MemoryOrder Order, typename T>
+inline T atomic_load(const volatile T* mem) {
+# ifdef ATOMIC_USE_SYNC_BUILTINS
+  if (Order == ORDER_SEQ_CST) memory_fence();
+  const T value = *mem;
+  if (Order != ORDER_RELAXED) memory_fence();
+  return value;
+# else
+  return __atomic_load_n(mem, Order);
+# endif
+}
+
+template<MemoryOrder Order, typename T>
+inline void atomic_store(volatile T* mem, const T value) {
+# ifdef ATOMIC_USE_SYNC_BUILTINS
+  if (Order != ORDER_RELAXED) memory_fence();
+  *mem = value;
+  if (Order == ORDER_SEQ_CST) memory_fence();
+# else
+  __atomic_store_n(mem, value, Order);
+# endif
+}
+
+/**
+ * @return the old value of *mem
+ */
+template<MemoryOrder Order, typename T>
+inline T atomic_exchange(volatile T* mem, const T value) {
+# ifdef ATOMIC_USE_SYNC_BUILTINS
+  T oldValue;
+  do {
+    oldValue = *mem;
+  } while (!__sync_bool_compare_and_swap(mem, oldValue, value));
+  return oldValue;
+# else
+  return __atomic_exchange_n(mem, value, Order);
+# endif
+}
+
+/**
+ * @return the old value of *mem
+ */
+template<MemoryOrder Order, typename T>
+inline T atomic_fetch_add(volatile T* mem, const T increment) {
+# ifdef ATOMIC_USE_SYNC_BUILTINS
+  return __sync_fetch_and_add(mem, increment);
+# else
+  return __atomic_fetch_add(mem, increment, Order);
+# endif
+}
+
+/**
+ * @return the old value of *mem
+ */
+template<MemoryOrder Order, typename T>
+inline T atomic_fetch_or(volatile T* mem, const T bits) {
+# ifdef ATOMIC_USE_SYNC_BUILTINS
+  return __sync_fetch_and_or(mem, bits);
+# else
+  return __atomic_fetch_or(mem, bits, Order);
+# endif
+}
+
+/**
+ * @return the old value of *mem
+ */
+template<MemoryOrder Order, typename T>
+inline T atomic_fetch_and(volatile T* mem, const T bits) {
+# ifdef ATOMIC_USE_SYNC_BUILTINS
+  return __sync_fetch_and_and(mem, bits);
+# else
+  return __atomic_fetch_and(mem, bits, Order);
+# endif
+}
+
+/**
+ * On failure, expected is updated with the value found in memory.
+ * Order applies on success, a failed CAS is only an acquire or relaxed load.
+ *
+ * @return true if CAS was sucessful
+ */
+template<MemoryOrder Order, typename T>
+inline bool atomic_compare_exchange(volatile T* mem, T& expected, const T desired) {
+# ifdef ATOMIC_USE_SYNC_BUILTINS
+  const T oldValue = __sync_val_compare_and_swap(mem, expected, desired);
+  if (oldValue == expected) {
+    return true;
+  }
+  expected = oldValue;
+  return false;
+# else
+  return __atomic_compare_exchange_n(mem, &expected, desired, false, Order,
+           (Order == ORDER_ACQ_REL || Order == ORDER_ACQUIRE) ? ORDER_ACQUIRE
+         : (Order == ORDER_SEQ_CST)                           ? ORDER_SEQ_CST
+         :                                                      ORDER_RELAXED);
+# endif
+}
+
 #endif
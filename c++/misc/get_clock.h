@@ -21,12 +21,114 @@
  * THE SOFTWARE.
  */
 
+#ifndef __GET_CLOCK_H__
+#define __GET_CLOCK_H__
+
 #include <stdint.h>
 #include <sys/time.h>
+#include <time.h>
+
+/**
+ * The delay loops of the benchmarks default to the uncalibrated float-add
+ * loops of the EPCC suite, to keep results comparable to earlier runs.
+ * With CALIBRATED_DELAY, a delay length is interpreted as nanoseconds and
+ * waited for with delay_ns().
+ */
+#ifndef CALIBRATED_DELAY
+  #define CALIBRATED_DELAY false
+#endif
+
+/**
+ * CLOCK_MONOTONIC_RAW is not slewed by NTP, thus, its rate is the one of the
+ * underlying hardware counter.
+ */
+#ifdef CLOCK_MONOTONIC_RAW
+  #define GET_CLOCK_SOURCE CLOCK_MONOTONIC_RAW
+#else
+  #define GET_CLOCK_SOURCE CLOCK_MONOTONIC
+#endif
+
+/**
+ * Duration over which the cycle counter is calibrated against the
+ * monotonic clock.
+ */
+#define CLOCK_CALIBRATION_NS (10 * 1000 * 1000)
 
-static uint64_t get_clock() {
-  struct timeval now;
-  gettimeofday(&now, NULL);
+/**
+ * A monotonic clock with nanosecond resolution, cheap enough to be taken
+ * inside of a barrier episode.
+ */
+static inline uint64_t get_clock_ns() {
+  struct timespec now;
+  clock_gettime(GET_CLOCK_SOURCE, &now);
   
-  return (uint64_t)((uint64_t)(now.tv_sec * 1000 * 1000) /* seconds */ + (uint64_t)now.tv_usec /* µseconds */); 
+  return (uint64_t)now.tv_sec * 1000 * 1000 * 1000 + (uint64_t)now.tv_nsec;
 }
+
+/**
+ * The benchmark clock in µseconds. It is only used for differences,
+ * so it is based on the monotonic clock instead of the wall clock.
+ */
+static inline uint64_t get_clock() {
+  return get_clock_ns() / 1000;
+}
+
+/**
+ * Reads the CPU's cycle counter. On x86 this is the TSC, which is assumed
+ * to be invariant, i.e., to tick at a constant rate on all cores.
+ * Other platforms fall back to the monotonic clock.
+ */
+static inline uint64_t get_cycles() {
+#if defined(__i386__) || defined(__x86_64__)
+  uint32_t lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t)hi << 32) | lo;
+#else
+  return get_clock_ns();
+#endif
+}
+
+/**
+ * Measures the rate of get_cycles() against get_clock_ns().
+ */
+static inline double calibrate_cycles_per_ns() {
+  const uint64_t startNs     = get_clock_ns();
+  const uint64_t startCycles = get_cycles();
+  
+  uint64_t nowNs;
+  do {
+    nowNs = get_clock_ns();
+  } while (nowNs - startNs < CLOCK_CALIBRATION_NS);
+  
+  const uint64_t cycles = get_cycles() - startCycles;
+  return (double)cycles / (double)(nowNs - startNs);
+}
+
+/**
+ * The calibration is done once, the first time it is needed.
+ */
+static inline double get_cycles_per_ns() {
+  static const double cyclesPerNs = calibrate_cycles_per_ns();
+  return cyclesPerNs;
+}
+
+static inline uint64_t cycles_to_ns(const uint64_t cycles) {
+  return (uint64_t)((double)cycles / get_cycles_per_ns());
+}
+
+static inline uint64_t ns_to_cycles(const uint64_t ns) {
+  return (uint64_t)((double)ns * get_cycles_per_ns());
+}
+
+/**
+ * Busy-waits for the given number of nanoseconds, based on the calibrated
+ * cycle counter to avoid the cost of a clock_gettime() per iteration.
+ */
+static inline void delay_ns(const uint64_t ns) {
+  const uint64_t start  = get_cycles();
+  const uint64_t cycles = ns_to_cycles(ns);
+  
+  while (get_cycles() - start < cycles) {}
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  This header file defines a log-linear latency histogram in the style of
+ *  HdrHistogram. Values below 2 * HISTOGRAM_SUB_BUCKETS are counted exactly,
+ *  every larger power of two is split into HISTOGRAM_SUB_BUCKETS linear
+ *  buckets, which bounds the relative error of a reported percentile by
+ *  1 / HISTOGRAM_SUB_BUCKETS independent of the magnitude of the value.
+ */
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+
+#define LOG2_HISTOGRAM_SUB_BUCKETS 5
+#define HISTOGRAM_SUB_BUCKETS      (1 << LOG2_HISTOGRAM_SUB_BUCKETS)
+
+// enough buckets for the full range of uint64_t
+#define HISTOGRAM_BUCKETS ((64 - LOG2_HISTOGRAM_SUB_BUCKETS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+class LatencyHistogram {
+public:
+  LatencyHistogram() : count(0), sum(0), min(~(uint64_t)0), max(0) {
+    memset(counts, 0, sizeof(counts));
+  }
+  
+  inline void record(const uint64_t value) {
+    counts[bucketOf(value)]++;
+    count++;
+    sum += value;
+    
+    if (value < min) min = value;
+    if (value > max) max = value;
+  }
+  
+  size_t   getCount() const { return count; }
+  uint64_t getMin()   const { return count ? min : 0; }
+  uint64_t getMax()   const { return max; }
+  double   getMean()  const { return count ? (double)sum / count : 0.0; }
+  
+  /**
+   * Returns the highest value which is equivalent, up to the resolution of
+   * the histogram, to the value at the given percentile.
+   */
+  uint64_t percentile(const double percent) const {
+    if (count == 0) {
+      return 0;
+    }
+    
+    size_t rank = (size_t)(percent / 100.0 * count + 0.5);
+    if (rank < 1)     rank = 1;
+    if (rank > count) rank = count;
+    
+    size_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+      seen += counts[i];
+      if (seen >= rank) {
+        const uint64_t highest = highestValueOf(i);
+        return highest < max ? highest : max;
+      }
+    }
+    
+    return max;
+  }
+  
+private:
+  static inline size_t bucketOf(const uint64_t value) {
+    const int magnitude = value ? 63 - __builtin_clzll(value) : 0;
+    const int shift     = magnitude > LOG2_HISTOGRAM_SUB_BUCKETS
+                            ? magnitude - LOG2_HISTOGRAM_SUB_BUCKETS : 0;
+    
+    return (size_t)shift * HISTOGRAM_SUB_BUCKETS + (size_t)(value >> shift);
+  }
+  
+  static inline uint64_t highestValueOf(const size_t bucket) {
+    if (bucket < 2 * HISTOGRAM_SUB_BUCKETS) {
+      return bucket;
+    }
+    
+    const int      shift    = (int)(bucket / HISTOGRAM_SUB_BUCKETS) - 1;
+    const uint64_t mantissa = bucket - (uint64_t)shift * HISTOGRAM_SUB_BUCKETS;
+    
+    return ((mantissa + 1) << shift) - 1;
+  }
+  
+  size_t   count;
+  uint64_t sum;
+  uint64_t min;
+  uint64_t max;
+  
+  size_t counts[HISTOGRAM_BUCKETS];
+};
+
+#endif
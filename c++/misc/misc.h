@@ -25,6 +25,10 @@
   #define DO_YIELD false
 #endif
 
+#ifndef CACHE_LINE_SIZE
+  #define CACHE_LINE_SIZE 64
+#endif
+
 #ifdef __APPLE__
   #define pthread_yield pthread_yield_np
 #endif
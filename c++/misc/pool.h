@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  This header file defines a pool for the tree nodes of the barriers, which
+ *  are allocated and released while participants register and drop.
+ *  Nodes are carved out of larger chunks, thus, the registration path does
+ *  not need to call malloc once the pool has grown to the size of the tree.
+ *  Every slot starts at a cache line boundary, so that nodes do not share
+ *  cache lines with their neighbors.
+ */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <cstddef>
+#include <new>
+
+#include "misc.h"
+#include "align.h"
+
+#if USE_PADDING
+  #define POOL_SLOT_ALIGNMENT CACHE_LINE_SIZE
+#else
+  #define POOL_SLOT_ALIGNMENT (2 * sizeof(void*))
+#endif
+
+/**
+ * Not thread-safe, allocate() and release() have to be serialized by the
+ * owner, i.e., by the lock or the combiner protecting the tree.
+ * Memory is only returned to the system by free() or the destructor.
+ *
+ * Usage:
+ *    T* node = ::new (pool.allocate()) T();
+ *    pool.release(node);
+ */
+template<typename T, size_t SlotsPerChunk = 32>
+class NodePool {
+public:
+  NodePool() : chunks(NULL), freeSlots(NULL), unusedSlots(0), nextUnused(NULL) {}
+  
+  ~NodePool() {
+    free();
+  }
+  
+  /**
+   * @return uninitialized memory for a single T
+   */
+  inline void* allocate() {
+    if (freeSlots) {
+      Slot* const slot = freeSlots;
+      freeSlots = slot->nextFree;
+      return slot;
+    }
+    
+    if (unusedSlots == 0) {
+      addChunk();
+    }
+    
+    void* const slot = nextUnused;
+    nextUnused += SLOT_SIZE;
+    unusedSlots--;
+    return slot;
+  }
+  
+  /**
+   * Destroys the node, its slot is reused by the next allocate().
+   */
+  inline void release(T* const node) {
+    node->~T();
+    
+    Slot* const slot = (Slot*)node;
+    slot->nextFree = freeSlots;
+    freeSlots = slot;
+  }
+  
+  /**
+   * Makes all slots available again at once, e.g., when a whole tree is
+   * discarded. The nodes are not destroyed, thus, T has to be trivially
+   * destructible or destroyed by the owner before.
+   */
+  void releaseAll() {
+    freeSlots   = NULL;
+    unusedSlots = 0;
+    nextUnused  = NULL;
+    
+    for (Chunk* chunk = chunks; chunk; chunk = chunk->next) {
+      char* slot = (char*)chunk + SLOT_SIZE;
+      for (size_t i = 0; i < SlotsPerChunk; i++, slot += SLOT_SIZE) {
+        ((Slot*)slot)->nextFree = freeSlots;
+        freeSlots = (Slot*)slot;
+      }
+    }
+  }
+  
+  /**
+   * Returns all chunks to the system. The nodes are not destroyed,
+   * and none of them may be used afterwards.
+   */
+  void free() {
+    while (chunks) {
+      Chunk* const next = chunks->next;
+      cache_aligned_free(chunks);
+      chunks = next;
+    }
+    
+    freeSlots   = NULL;
+    unusedSlots = 0;
+    nextUnused  = NULL;
+  }
+  
+private:
+  static const size_t SLOT_SIZE =
+    (sizeof(T) + POOL_SLOT_ALIGNMENT - 1) / POOL_SLOT_ALIGNMENT * POOL_SLOT_ALIGNMENT;
+  
+  // the header occupies the first slot of every chunk
+  struct Chunk {
+    Chunk* next;
+  };
+  
+  struct Slot {
+    Slot* nextFree;
+  };
+  
+  void addChunk() {
+    Chunk* const chunk = (Chunk*)cache_aligned_malloc(SLOT_SIZE * (SlotsPerChunk + 1));
+    if (chunk == NULL) {
+      throw std::bad_alloc();
+    }
+    
+    chunk->next = chunks;
+    chunks = chunk;
+    
+    nextUnused  = (char*)chunk + SLOT_SIZE;
+    unusedSlots = SlotsPerChunk;
+  }
+  
+  // not copyable, the chunks are owned by a single pool
+  NodePool(const NodePool&);
+  NodePool& operator=(const NodePool&);
+  
+  Chunk* chunks;
+  Slot*  freeSlots;
+  size_t unusedSlots;
+  char*  nextUnused;
+};
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  This header file defines the instrumentation counters of the barriers.
+ *  Every thread counts into its own cache line padded block of counters,
+ *  the blocks are never freed, thus, a snapshot also includes the counts
+ *  of threads which terminated already.
+ *
+ *  The counters are only compiled in with BARRIER_STATS, otherwise
+ *  stats_add() is empty and WAIT_POLICY is not wrapped.
+ */
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdio>
+
+#include "atomic.h"
+#include "align.h"
+#include "get_clock.h"
+
+#ifndef BARRIER_STATS
+  #define BARRIER_STATS false
+#endif
+
+enum BarrierStat {
+  STAT_EPISODES,          // waits on a phaser
+  STAT_SPINS,             // unsuccessful checks of a wait loop's condition
+  STAT_WAIT_CYCLES,       // cycles spent in wait loops, cf. get_cycles()
+  STAT_CAS_FAILURES,      // compare-and-swap retries on the flags of a tree node
+  STAT_MASTER_ELECTIONS,  // waits which made the participant the master
+  NUM_BARRIER_STATS
+};
+
+static const char* const barrier_stat_names[NUM_BARRIER_STATS] = {
+  "episodes",
+  "spins",
+  "wait cycles",
+  "CAS failures",
+  "master elections"
+};
+
+class ThreadStats : public CacheLineAligned {
+public:
+  ThreadStats() : id(-1), next(NULL) {
+    for (int i = 0; i < NUM_BARRIER_STATS; i++) {
+      counters[i] = 0;
+    }
+  }
+  
+  // only written by the owning thread
+  volatile uint64_t counters[NUM_BARRIER_STATS];
+  
+  // the id given to stats_attach(), or -1
+  volatile int id;
+  
+  ThreadStats* next;
+  
+  CACHE_LINE_PAD(padding);
+};
+
+/**
+ * Head of the list of all threads' counters, new blocks are pushed with CAS.
+ */
+inline ThreadStats* volatile* all_thread_stats() {
+  static ThreadStats* volatile head = NULL;
+  return &head;
+}
+
+inline ThreadStats* thread_stats() {
+  static __thread ThreadStats* stats = NULL;
+  
+  if (stats == NULL) {
+    stats = new ThreadStats();
+    
+    ThreadStats* head = atomic_load<ORDER_RELAXED>(all_thread_stats());
+    do {
+      stats->next = head;
+    } while (!atomic_compare_exchange<ORDER_RELEASE>(all_thread_stats(), head, stats));
+  }
+  
+  return stats;
+}
+
+/**
+ * Labels the counters of the calling thread with the id of its
+ * participant, cf. trace_attach().
+ */
+inline void stats_attach(const size_t id) {
+  if (!BARRIER_STATS) {
+    return;
+  }
+  
+  thread_stats()->id = (int)id;
+}
+
+inline void stats_add(const BarrierStat stat, const uint64_t value = 1) {
+  if (!BARRIER_STATS) {
+    return;
+  }
+  
+  ThreadStats* const stats = thread_stats();
+  stats->counters[stat] = stats->counters[stat] + value;
+}
+
+/**
+ * A consistent-enough copy of counters, to be taken before and after the
+ * measured section. Counters of running threads are read without stopping
+ * them, thus, a snapshot can miss their latest increments.
+ */
+struct BarrierStatsSnapshot {
+  uint64_t counters[NUM_BARRIER_STATS];
+  
+  // the attached id of a single thread's snapshot, or -1
+  int id;
+  
+  BarrierStatsSnapshot() : id(-1) {
+    for (int i = 0; i < NUM_BARRIER_STATS; i++) {
+      counters[i] = 0;
+    }
+  }
+  
+  void add(const ThreadStats* const stats) {
+    for (int i = 0; i < NUM_BARRIER_STATS; i++) {
+      counters[i] += atomic_load<ORDER_RELAXED>(&stats->counters[i]);
+    }
+  }
+  
+  BarrierStatsSnapshot operator-(const BarrierStatsSnapshot& earlier) const {
+    BarrierStatsSnapshot difference;
+    for (int i = 0; i < NUM_BARRIER_STATS; i++) {
+      difference.counters[i] = counters[i] - earlier.counters[i];
+    }
+    return difference;
+  }
+  
+  void print(const char* const name) const {
+    printf("%-8s", name);
+    for (int i = 0; i < NUM_BARRIER_STATS; i++) {
+      printf(" %17llu", (unsigned long long)counters[i]);
+    }
+    printf("\n");
+  }
+};
+
+/**
+ * @return the sum of the counters of all threads
+ */
+inline BarrierStatsSnapshot stats_snapshot() {
+  BarrierStatsSnapshot snapshot;
+  
+  for (const ThreadStats* stats = atomic_load<ORDER_ACQUIRE>(all_thread_stats());
+       stats != NULL; stats = stats->next) {
+    snapshot.add(stats);
+  }
+  
+  return snapshot;
+}
+
+/**
+ * Copies the counters of every thread separately, most recently started
+ * thread first, together with the id the thread attached. In the benchmarks
+ * a thread runs a single participant, thus, these are also the counts per
+ * participant.
+ * @return the number of threads, which can be larger than maxThreads
+ */
+inline size_t stats_snapshot_threads(BarrierStatsSnapshot* const snapshots, const size_t maxThreads) {
+  size_t numThreads = 0;
+  
+  for (const ThreadStats* stats = atomic_load<ORDER_ACQUIRE>(all_thread_stats());
+       stats != NULL; stats = stats->next) {
+    if (numThreads < maxThreads) {
+      snapshots[numThreads] = BarrierStatsSnapshot();
+      snapshots[numThreads].add(stats);
+      snapshots[numThreads].id = atomic_load<ORDER_RELAXED>(&stats->id);
+    }
+    numThreads++;
+  }
+  
+  return numThreads;
+}
+
+/**
+ * Prints the counters of every thread, ordered by the attached ids, and
+ * their sum. Threads which did not attach are printed last, as "-".
+ * Has to be called after all threads did their last wait, otherwise their
+ * latest increments are missing.
+ */
+inline void stats_report() {
+  if (!BARRIER_STATS) {
+    return;
+  }
+  
+  const size_t maxThreads = stats_snapshot_threads(NULL, 0);
+  BarrierStatsSnapshot* const threads = new BarrierStatsSnapshot[maxThreads];
+  const size_t numThreads = stats_snapshot_threads(threads, maxThreads);
+  const size_t numCopied  = (numThreads < maxThreads) ? numThreads : maxThreads;
+  
+  // insertion sort by id, unattached threads last
+  for (size_t i = 1; i < numCopied; i++) {
+    const BarrierStatsSnapshot current = threads[i];
+    const unsigned int key = (unsigned int)current.id;
+    
+    size_t j = i;
+    while (j > 0 && (unsigned int)threads[j - 1].id > key) {
+      threads[j] = threads[j - 1];
+      j--;
+    }
+    threads[j] = current;
+  }
+  
+  printf("\n");
+  printf("--------------------------------------------------------\n");
+  printf("Barrier counters\n");
+  printf("\n");
+  printf("%-8s", "thread");
+  for (int i = 0; i < NUM_BARRIER_STATS; i++) {
+    printf(" %17s", barrier_stat_names[i]);
+  }
+  printf("\n");
+  
+  BarrierStatsSnapshot total;
+  for (size_t i = 0; i < numCopied; i++) {
+    char name[24];
+    if (threads[i].id < 0) {
+      snprintf(name, sizeof(name), "-");
+    }
+    else {
+      snprintf(name, sizeof(name), "%d", threads[i].id);
+    }
+    threads[i].print(name);
+    
+    for (int j = 0; j < NUM_BARRIER_STATS; j++) {
+      total.counters[j] += threads[i].counters[j];
+    }
+  }
+  total.print("total");
+  printf("\n");
+  
+  delete[] threads;
+}
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  This header file provides access to the CPU topology, i.e., which cores
+ *  share a cache or a package. On Linux the information is read from
+ *  /sys/devices/system/cpu, on all other platforms every query fails with -1.
+ */
+
+#ifndef __TOPOLOGY_H__
+#define __TOPOLOGY_H__
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+  #include <sched.h>
+  #include <unistd.h>
+#endif
+
+#define TOPOLOGY_SYSFS_CPU "/sys/devices/system/cpu"
+
+/**
+ * Reads the first integer from the given file.
+ * @return the value read, or -1 if the file is not available
+ */
+inline int _topology_read_int(const char* const path) {
+  FILE* const file = fopen(path, "r");
+  if (file == NULL) {
+    return -1;
+  }
+  
+  int value;
+  if (fscanf(file, "%d", &value) != 1) {
+    value = -1;
+  }
+  
+  fclose(file);
+  return value;
+}
+
+/**
+ * @return the CPU the calling thread is currently executing on, or -1
+ */
+inline int topology_current_cpu() {
+#ifdef __linux__
+  return sched_getcpu();
+#else
+  return -1;
+#endif
+}
+
+/**
+ * @return the number of configured CPUs, i.e., all CPU ids are below it, or -1
+ */
+inline int topology_num_cpus() {
+#ifdef __linux__
+  return (int)sysconf(_SC_NPROCESSORS_CONF);
+#else
+  return -1;
+#endif
+}
+
+/**
+ * @return the id of the physical package/socket of the given CPU, or -1
+ */
+inline int topology_package_id(const int cpu) {
+  if (cpu < 0) {
+    return -1;
+  }
+  
+  char path[256];
+  snprintf(path, sizeof(path), TOPOLOGY_SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+  return _topology_read_int(path);
+}
+
+/**
+ * Determines the cache of the given level, which is used by the given CPU.
+ * Data and unified caches are considered, instruction caches are ignored.
+ *
+ * @return an id which is equal for all CPUs sharing that cache, or -1
+ */
+inline int topology_cache_id(const int cpu, const int level) {
+  if (cpu < 0) {
+    return -1;
+  }
+  
+  char path[256];
+  
+  for (int index = 0; ; index++) {
+    snprintf(path, sizeof(path), TOPOLOGY_SYSFS_CPU "/cpu%d/cache/index%d/level", cpu, index);
+    const int indexLevel = _topology_read_int(path);
+    
+    if (indexLevel == -1) {
+      return -1;  // no more caches
+    }
+    
+    if (indexLevel != level) {
+      continue;
+    }
+    
+    snprintf(path, sizeof(path), TOPOLOGY_SYSFS_CPU "/cpu%d/cache/index%d/type", cpu, index);
+    FILE* const file = fopen(path, "r");
+    char type[32] = "";
+    if (file) {
+      if (fscanf(file, "%31s", type) != 1) {
+        type[0] = '\0';
+      }
+      fclose(file);
+    }
+    
+    if (strcmp(type, "Instruction") == 0) {
+      continue;
+    }
+    
+    snprintf(path, sizeof(path), TOPOLOGY_SYSFS_CPU "/cpu%d/cache/index%d/id", cpu, index);
+    const int id = _topology_read_int(path);
+    if (id != -1) {
+      return id;
+    }
+    
+    // older kernels do not provide the id, but the first CPU sharing the
+    // cache identifies it just as well
+    snprintf(path, sizeof(path), TOPOLOGY_SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+    return _topology_read_int(path);
+  }
+}
+
+#endif
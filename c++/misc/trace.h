@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  This header file defines the event tracing of participants. Every
+ *  thread writes its events into its own ring buffer, thus, recording an
+ *  event neither locks nor shares a cache line with other threads. At exit
+ *  the buffers are written to BARRIER_TRACE_FILE in the Chrome trace-event
+ *  format, which can be opened with chrome://tracing or Perfetto. Each call
+ *  is one complete event on the timeline of its thread, so the last thread
+ *  to arrive is the one whose next() or barrier() returned first.
+ *
+ *  Tracing is only compiled in with BARRIER_TRACE, otherwise TraceScope is
+ *  empty. A ring buffer keeps the last TRACE_BUFFER_EVENTS events per thread.
+ *  The benchmarks allocate the buffers before timing with trace_prepare().
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include "atomic.h"
+#include "align.h"
+#include "get_clock.h"
+
+#ifndef BARRIER_TRACE
+  #define BARRIER_TRACE false
+#endif
+
+#ifndef BARRIER_TRACE_FILE
+  #define BARRIER_TRACE_FILE "barrier-trace.json"
+#endif
+
+// has to be a power of 2
+#ifndef TRACE_BUFFER_EVENTS
+  #define TRACE_BUFFER_EVENTS (64 * 1024)
+#endif
+
+enum TraceKind {
+  TRACE_ADD,
+  TRACE_RESUME,
+  TRACE_NEXT,
+  TRACE_BARRIER,
+  TRACE_DROP,
+  NUM_TRACE_KINDS
+};
+
+static const char* const trace_kind_names[NUM_TRACE_KINDS] = {
+  "add",
+  "resume",
+  "next",
+  "barrier",
+  "drop"
+};
+
+struct TraceEvent {
+  uint64_t  start;    // cycles, cf. get_cycles()
+  uint64_t  end;
+  uint32_t  episode;  // number of next() and barrier() calls of the thread before
+  TraceKind kind;
+};
+
+class TraceBuffer : public CacheLineAligned {
+public:
+  TraceBuffer(const int thread) : written(0), episode(0), thread(thread), next(NULL) {
+    // touch the events, so that page faults do not show up in the trace
+    for (size_t i = 0; i < TRACE_BUFFER_EVENTS; i++) {
+      events[i].start   = 0;
+      events[i].end     = 0;
+      events[i].episode = 0;
+      events[i].kind    = TRACE_ADD;
+    }
+  }
+  
+  inline void record(const TraceKind kind, const uint64_t start, const uint64_t end) {
+    TraceEvent& event = events[written & (TRACE_BUFFER_EVENTS - 1)];
+    event.start   = start;
+    event.end     = end;
+    event.episode = episode;
+    event.kind    = kind;
+    
+    if (kind == TRACE_NEXT || kind == TRACE_BARRIER) {
+      episode++;
+    }
+    
+    // publishes the event to the thread writing the trace
+    atomic_store<ORDER_RELEASE>(&written, written + 1);
+  }
+  
+  TraceEvent events[TRACE_BUFFER_EVENTS];
+  
+  // only written by the owning thread
+  volatile uint64_t written;
+  uint32_t          episode;
+  
+  const int    thread;
+  TraceBuffer* next;
+};
+
+inline void trace_dump_at_exit();
+
+/**
+ * Head of the list of all threads' buffers, new buffers are pushed with CAS.
+ */
+inline TraceBuffer* volatile* all_trace_buffers() {
+  static TraceBuffer* volatile head = NULL;
+  return &head;
+}
+
+/**
+ * The buffers allocated by trace_prepare(), indexed by thread id.
+ */
+struct TracePool {
+  TraceBuffer** buffers;
+  size_t        size;
+};
+
+inline TracePool* trace_pool() {
+  static TracePool pool = { NULL, 0 };
+  return &pool;
+}
+
+inline TraceBuffer*& current_trace_buffer() {
+  static __thread TraceBuffer* buffer = NULL;
+  return buffer;
+}
+
+inline TraceBuffer* trace_new_buffer() {
+  static int numBuffers = 0;
+  
+  const int thread = atomic_add_and_fetch(&numBuffers, 1) - 1;
+  TraceBuffer* const buffer = new TraceBuffer(thread);
+  
+  // the first buffer makes sure the trace is written
+  if (thread == 0) {
+    atexit(trace_dump_at_exit);
+  }
+  
+  TraceBuffer* head = atomic_load<ORDER_RELAXED>(all_trace_buffers());
+  do {
+    buffer->next = head;
+  } while (!atomic_compare_exchange<ORDER_RELEASE>(all_trace_buffers(), head, buffer));
+  
+  return buffer;
+}
+
+/**
+ * Allocates the buffers of the given number of threads up front, so that
+ * neither the allocation nor the page faults fall into a timed region.
+ * Has to be called before the threads are started, cf. trace_attach().
+ */
+inline void trace_prepare(const size_t numThreads) {
+  TracePool* const pool = trace_pool();
+  if (!BARRIER_TRACE || pool->size >= numThreads) {
+    return;
+  }
+  
+  TraceBuffer** const buffers = new TraceBuffer*[numThreads];
+  for (size_t i = 0; i < numThreads; i++) {
+    buffers[i] = (i < pool->size) ? pool->buffers[i] : trace_new_buffer();
+  }
+  
+  delete[] pool->buffers;
+  pool->buffers = buffers;
+  pool->size    = numThreads;
+}
+
+/**
+ * Lets the calling thread record into the prepared buffer of the given id.
+ * Threads running one after the other can share an id.
+ */
+inline void trace_attach(const size_t id) {
+  if (BARRIER_TRACE && id < trace_pool()->size) {
+    current_trace_buffer() = trace_pool()->buffers[id];
+  }
+}
+
+/**
+ * Threads which were not attached, e.g., users of the C API,
+ * get their buffer allocated on their first event.
+ */
+inline TraceBuffer* trace_buffer() {
+  TraceBuffer*& buffer = current_trace_buffer();
+  
+  if (buffer == NULL) {
+    buffer = trace_new_buffer();
+  }
+  
+  return buffer;
+}
+
+/**
+ * Frees all buffers, no thread may record an event afterwards.
+ */
+inline void trace_release() {
+  TraceBuffer* buffer = atomic_exchange<ORDER_ACQUIRE>(all_trace_buffers(), (TraceBuffer*)NULL);
+  while (buffer) {
+    TraceBuffer* const next = buffer->next;
+    delete buffer;
+    buffer = next;
+  }
+  
+  TracePool* const pool = trace_pool();
+  delete[] pool->buffers;
+  pool->buffers = NULL;
+  pool->size    = 0;
+  
+  current_trace_buffer() = NULL;
+}
+
+/**
+ * Records the lifetime of the scope as one event of the calling thread.
+ */
+class TraceScope {
+public:
+  inline TraceScope(const TraceKind kind) : kind(kind), start(BARRIER_TRACE ? get_cycles() : 0) {}
+  
+  inline ~TraceScope() {
+    if (BARRIER_TRACE) {
+      trace_buffer()->record(kind, start, get_cycles());
+    }
+  }
+  
+private:
+  const TraceKind kind;
+  const uint64_t  start;
+};
+
+/**
+ * Traces a single call, e.g., TRACED(TRACE_NEXT, participant->next());
+ */
+#define TRACED(kind, call) do { TraceScope _trace(kind); call; } while (0)
+
+/**
+ * Registers a new participant and traces the registration.
+ */
+template<class ParticipantType, class BarrierType>
+inline ParticipantType* traced_add(BarrierType* const barrier) {
+  TraceScope trace(TRACE_ADD);
+  return new ParticipantType(barrier);
+}
+
+/**
+ * Registers a new participant in the given mode, e.g., SyncTree::WAIT_ONLY.
+ */
+template<class ParticipantType, class BarrierType, typename ModeType>
+inline ParticipantType* traced_add(BarrierType* const barrier, const ModeType mode) {
+  TraceScope trace(TRACE_ADD);
+  return new ParticipantType(barrier, mode);
+}
+
+/**
+ * Writes all events to the given file, the timestamps are given in
+ * µseconds relative to the earliest recorded event.
+ * Threads still recording can overwrite the oldest events in between.
+ */
+inline bool trace_dump(const char* const fileName) {
+  FILE* const file = fopen(fileName, "w");
+  if (file == NULL) {
+    perror("Could not open the trace file");
+    return false;
+  }
+  
+  TraceBuffer* const head = atomic_load<ORDER_ACQUIRE>(all_trace_buffers());
+  
+  uint64_t base = ~(uint64_t)0;
+  for (TraceBuffer* buffer = head; buffer != NULL; buffer = buffer->next) {
+    const uint64_t written = atomic_load<ORDER_ACQUIRE>(&buffer->written);
+    const uint64_t first   = written > TRACE_BUFFER_EVENTS ? written - TRACE_BUFFER_EVENTS : 0;
+    
+    if (first < written && buffer->events[first & (TRACE_BUFFER_EVENTS - 1)].start < base) {
+      base = buffer->events[first & (TRACE_BUFFER_EVENTS - 1)].start;
+    }
+  }
+  
+  fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+  
+  bool isFirst = true;
+  for (TraceBuffer* buffer = head; buffer != NULL; buffer = buffer->next) {
+    const uint64_t written = atomic_load<ORDER_ACQUIRE>(&buffer->written);
+    const uint64_t first   = written > TRACE_BUFFER_EVENTS ? written - TRACE_BUFFER_EVENTS : 0;
+    
+    for (uint64_t i = first; i < written; i++) {
+      const TraceEvent& event = buffer->events[i & (TRACE_BUFFER_EVENTS - 1)];
+      
+      fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                    "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"episode\": %u}}",
+              isFirst ? "" : ",\n",
+              trace_kind_names[event.kind], buffer->thread,
+              cycles_to_ns(event.start - base) / 1000.0,
+              cycles_to_ns(event.end - event.start) / 1000.0,
+              (unsigned int)event.episode);
+      isFirst = false;
+    }
+  }
+  
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  return true;
+}
+
+inline void trace_dump_at_exit() {
+  if (trace_dump(BARRIER_TRACE_FILE)) {
+    printf("Trace written to %s\n", BARRIER_TRACE_FILE);
+  }
+  trace_release();
+}
+
+#endif
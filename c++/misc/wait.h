@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2010 Stefan Marr, Vrije Universiteit Brussel
+ * <http://www.stefan-marr.de/>, <http://code.google.com/p/barriers/>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *  This header file defines the wait policies used by all spin loops of the
+ *  barriers. A policy is constructed with the address that is waited on and
+ *  its wait() is called once per unsuccessful check of the condition:
+ *
+ *    WAIT_POLICY waiter(&flag);
+ *    while (flag != sense) waiter.wait();
+ *
+ *  Every thread changing such an address has to call WAIT_POLICY::wake()
+ *  afterwards. For all policies except ParkWait, wake() is empty.
+ *
+ *  The policy is selected at build time with WAIT_POLICY, DO_YIELD selects
+ *  YieldWait as default. With BARRIER_STATS, the selected policy is wrapped
+ *  in CountingWait.
+ */
+
+#ifndef __WAIT_H__
+#define __WAIT_H__
+
+#include <cstddef>
+#include <climits>
+#include <sched.h>
+
+#ifdef __linux__
+  #include <unistd.h>
+  #include <sys/syscall.h>
+  #include <linux/futex.h>
+#endif
+
+#include "misc.h"
+#include "atomic.h"
+#include "align.h"
+#include "stats.h"
+
+// number of unsuccessful checks before yielding or parking
+#ifndef WAIT_SPIN_LIMIT
+  #define WAIT_SPIN_LIMIT 1024
+#endif
+
+// upper bound for the number of pause instructions of ExponentialBackoffWait
+#ifndef WAIT_MAX_BACKOFF
+  #define WAIT_MAX_BACKOFF 1024
+#endif
+
+/**
+ * Tell the processor that we are in a spin loop.
+ */
+inline void cpu_relax() {
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield" ::: "memory");
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/**
+ * Re-checks the condition as fast as possible.
+ */
+class SpinWait {
+public:
+  inline SpinWait(const volatile void* const) {}
+  inline void wait() {}
+  static inline void wake(const volatile void* const) {}
+};
+
+/**
+ * Issues a pause instruction between the checks.
+ */
+class PauseWait {
+public:
+  inline PauseWait(const volatile void* const) {}
+  inline void wait() { cpu_relax(); }
+  static inline void wake(const volatile void* const) {}
+};
+
+/**
+ * Doubles the number of pause instructions between the checks,
+ * up to WAIT_MAX_BACKOFF.
+ */
+class ExponentialBackoffWait {
+public:
+  inline ExponentialBackoffWait(const volatile void* const) : backoff(1) {}
+  
+  inline void wait() {
+    for (unsigned int i = 0; i < backoff; i++) {
+      cpu_relax();
+    }
+    
+    if (backoff < WAIT_MAX_BACKOFF) {
+      backoff <<= 1;
+    }
+  }
+  
+  static inline void wake(const volatile void* const) {}
+  
+private:
+  unsigned int backoff;
+};
+
+/**
+ * Spins WAIT_SPIN_LIMIT times, and yields the processor afterwards.
+ */
+class YieldWait {
+public:
+  inline YieldWait(const volatile void* const) : spins(0) {}
+  
+  inline void wait() {
+    if (spins < WAIT_SPIN_LIMIT) {
+      spins++;
+      cpu_relax();
+    }
+    else {
+      sched_yield();
+    }
+  }
+  
+  static inline void wake(const volatile void* const) {}
+  
+private:
+  unsigned int spins;
+};
+
+/**
+ * The waiters of all addresses hashing to the same bucket park on its
+ * sequence number, which is advanced by every wake() with waiters present.
+ */
+struct ParkingBucket {
+  volatile int sequence;
+  volatile int waiters;
+  CACHE_LINE_PAD(padding);
+};
+
+#define PARKING_BUCKETS 64
+
+inline ParkingBucket* parking_bucket(const volatile void* const address) {
+  static ParkingBucket buckets[PARKING_BUCKETS];
+  
+  const size_t key = (size_t)address / CACHE_LINE_SIZE;
+  return &buckets[(key ^ (key >> 6)) % PARKING_BUCKETS];
+}
+
+/**
+ * Spins WAIT_SPIN_LIMIT times, and parks the thread on a futex afterwards.
+ * Without futexes, it yields instead of parking.
+ *
+ * A waiter first registers in the bucket and returns to re-check the
+ * condition, only the next wait() sleeps, and only if no wake() happened
+ * in between. Since wake() checks for waiters after the address was changed,
+ * either the waiter sees the change, or wake() sees the waiter.
+ */
+class ParkWait {
+public:
+  inline ParkWait(const volatile void* const address)
+  : bucket(parking_bucket(address)), spins(0), registered(false), sequence(0) {}
+  
+  inline ~ParkWait() {
+    if (registered) {
+      atomic_add_and_fetch((int*)&bucket->waiters, -1);
+    }
+  }
+  
+  inline void wait() {
+    if (spins < WAIT_SPIN_LIMIT) {
+      spins++;
+      cpu_relax();
+    }
+    else if (not registered) {
+      registered = true;
+      atomic_add_and_fetch((int*)&bucket->waiters, 1);
+      memory_fence();
+      sequence = bucket->sequence;
+    }
+    else {
+#ifdef __linux__
+      syscall(SYS_futex, (int*)&bucket->sequence, FUTEX_WAIT_PRIVATE, sequence, NULL, NULL, 0);
+#else
+      sched_yield();
+#endif
+      sequence = bucket->sequence;
+      memory_fence();
+    }
+  }
+  
+  static inline void wake(const volatile void* const address) {
+    ParkingBucket* const bucket = parking_bucket(address);
+    
+    memory_fence();
+    if (bucket->waiters > 0) {
+      atomic_add_and_fetch((int*)&bucket->sequence, 1);
+#ifdef __linux__
+      syscall(SYS_futex, (int*)&bucket->sequence, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+    }
+  }
+  
+private:
+  ParkingBucket* const bucket;
+  unsigned int spins;
+  bool registered;
+  int  sequence;
+};
+
+#ifndef WAIT_POLICY
+  #if DO_YIELD
+    #define WAIT_POLICY YieldWait
+  #else
+    #define WAIT_POLICY SpinWait
+  #endif
+#endif
+
+/**
+ * Counts the unsuccessful checks and the cycles from the first of them
+ * until the condition holds, loops which do not wait are not timed.
+ */
+template<class Policy>
+class CountingWait {
+public:
+  inline CountingWait(const volatile void* const address)
+  : policy(address), spins(0), start(0) {}
+  
+  inline ~CountingWait() {
+    if (spins > 0) {
+      stats_add(STAT_SPINS, spins);
+      stats_add(STAT_WAIT_CYCLES, get_cycles() - start);
+    }
+  }
+  
+  inline void wait() {
+    if (spins == 0) {
+      start = get_cycles();
+    }
+    spins++;
+    policy.wait();
+  }
+  
+  static inline void wake(const volatile void* const address) {
+    Policy::wake(address);
+  }
+  
+private:
+  Policy   policy;
+  uint64_t spins;
+  uint64_t start;
+};
+
+#if BARRIER_STATS
+  typedef CountingWait<WAIT_POLICY> CountedWaitPolicy;
+  #undef  WAIT_POLICY
+  #define WAIT_POLICY CountedWaitPolicy
+#endif
+
+#endif
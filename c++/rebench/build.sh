@@ -3,28 +3,6 @@
 
 START_DIR=`pwd`
 
-function compile_microbenches {
-  cd epcc
-
-  for coreNum in *
-  do
-	if [[ "$coreNum" =~ ^[0-9]+$ ]]
-	then
-		echo Build EPCC benchmark for cores=$coreNum
-		cd $coreNum
-		DIR=`pwd`
-		cd ../../../
-		rm *.epcc *.dynamic *.epcc-simple *.absoh *.lioh
-		NUM_PARTICIPANTS=$coreNum make 
-		mv *.epcc *.epcc-simple *.absoh *.lioh $DIR/
-		mv *.dynamic $DIR/../../dynamic/$coreNum/
-		rm *.dynamic
-		cd -
-		cd ..	   
-	fi
-  done
-}
-
 function complie_splash {
   cd $START_DIR
   cd splash
@@ -57,7 +35,17 @@ function complie_splash {
   done
 }
 
-compile_microbenches
+# the benchmark driver covers all core counts and microbenchmarks at once,
+# e.g., barrier-bench -a SyncTreePhaser -b epcc -n 16, cf. bar.conf
+function compile_driver {
+  cd $START_DIR/..
+  echo Build the benchmark driver
+  rm -f barrier-bench
+  make barrier-bench OPT="-O3 -no_exceptions -DNDEBUG=1"
+  mv barrier-bench $START_DIR/
+}
+
 complie_splash
+compile_driver
 
 
@@ -1,4 +0,0 @@
-NUM_PARTICIPANTS?=32
-SKIP_REFERENCE_TIME=1
-OPT=-O3 -no_exceptions -DNDEBUG=1
-#OPT=-g -O0 -no_exceptions -DNDEBUG=1